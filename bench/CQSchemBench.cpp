@@ -0,0 +1,446 @@
+#include <CQSchem.h>
+
+#include <QApplication>
+#include <QResizeEvent>
+#include <QImage>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <sys/resource.h>
+
+// headless simulation benchmark and regression harness.
+//
+// Builds each named circuit (execGate names), places it, paints it to a fixed size
+// offscreen image and then runs ticks with randomized input nets. Results are written
+// to stdout as JSON.
+//
+// With -baseline the results are compared against a stored result file (output of a
+// previous run, see -save_baseline) and the exit status is 1 if any metric is worse
+// than the baseline by more than the threshold percentage, if a requested circuit in
+// the baseline fails to build or if a requested circuit has no baseline metrics to
+// compare (the check never passes without comparing). The exit status is also 1 if any
+// circuit fails to build.
+//
+// bench/baseline.json lists the default circuits without metrics (timings are machine
+// specific) so checks against it fail until it is refreshed on the reference machine.
+// Run from the bench directory:
+//   ../bin/CQSchemBench -repeat 3 -save_baseline baseline.json   (refresh)
+//   ../bin/CQSchemBench -repeat 3 -baseline baseline.json        (check)
+//
+// usage: CQSchemBench [-ticks <n>] [-seconds <t>] [-seed <n>] [-repeat <n>]
+//                     [-optimize] [-aig] [-perf]
+//                     [-baseline <file>] [-save_baseline <file>] [-threshold <percent>]
+//                     [<gate_name> ...]
+
+struct Options {
+  int    maxTicks { 100000 };
+  double seconds  { 1.0 };
+  int    repeat   { 1 };
+  bool   optimize { false };
+  bool   aig      { false };
+  bool   perf     { false };
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double
+elapsedMs(const Clock::time_point &t1, const Clock::time_point &t2)
+{
+  return std::chrono::duration<double, std::milli>(t2 - t1).count();
+}
+
+static long
+peakRSS()
+{
+  // peak resident set size (KB on linux)
+  struct rusage usage;
+
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  return usage.ru_maxrss;
+}
+
+// run benchmark for circuit (empty object if invalid)
+static QJsonObject
+runBenchmark(const std::string &name, const Options &options, std::mt19937 &rng)
+{
+  QJsonObject result;
+
+  double constructMs = 0.0, layoutMs = 0.0, paintMs = 0.0;
+
+  // construction, layout and paint are best of repeat runs (simulate last run)
+  for (int r = 0; r < options.repeat; ++r) {
+    auto *window = new CQSchem::Window(/*waveform*/false);
+
+    auto *schem = window->schem();
+
+    schem->setOptimize(options.optimize);
+    schem->setAig     (options.aig);
+
+    if (options.perf)
+      schem->setPerf(true);
+
+    //---
+
+    auto t1 = Clock::now();
+
+    if (! schem->execGate(name.c_str())) {
+      delete window;
+
+      return QJsonObject();
+    }
+
+    auto t2 = Clock::now();
+
+    schem->place();
+
+    auto t3 = Clock::now();
+
+    // paint fixed size view (first paint routes connections)
+    QSize size(800, 800);
+
+    schem->resize(size);
+
+    QResizeEvent resizeEvent(size, QSize());
+
+    QApplication::sendEvent(schem, &resizeEvent);
+
+    QImage image(size, QImage::Format_ARGB32);
+
+    auto t4 = Clock::now();
+
+    schem->render(&image);
+
+    auto t5 = Clock::now();
+
+    if (r == 0 || elapsedMs(t1, t2) < constructMs) constructMs = elapsedMs(t1, t2);
+    if (r == 0 || elapsedMs(t2, t3) < layoutMs   ) layoutMs    = elapsedMs(t2, t3);
+    if (r == 0 || elapsedMs(t4, t5) < paintMs    ) paintMs     = elapsedMs(t4, t5);
+
+    if (r < options.repeat - 1) {
+      delete window;
+
+      continue;
+    }
+
+    //---
+
+    // input nets (no drivers) are randomized each tick
+    std::vector<CQSchem::Connection *> inputs;
+
+    for (const auto &connection : schem->connections()) {
+      if (connection->isInput())
+        inputs.push_back(connection);
+    }
+
+    auto ng = schem->gates().size();
+
+    int ticks = 0;
+
+    // counters enabled once for whole run
+    schem->startPerfBatch();
+
+    auto t6 = Clock::now();
+    auto t7 = t6;
+
+    while (ticks < options.maxTicks) {
+      for (const auto &input : inputs)
+        input->setValue(rng() & 1);
+
+      schem->exec();
+
+      ++ticks;
+
+      // check time every 16 ticks
+      if ((ticks & 15) == 0) {
+        t7 = Clock::now();
+
+        if (elapsedMs(t6, t7) >= 1000.0*options.seconds)
+          break;
+      }
+    }
+
+    t7 = Clock::now();
+
+    schem->stopPerfBatch();
+
+    double simMs = std::max(elapsedMs(t6, t7), 1E-6);
+
+    //---
+
+    result["name"              ] = QString(name.c_str());
+    result["gates"             ] = double(ng);
+    result["connections"       ] = double(schem->connections().size());
+    result["inputs"            ] = double(inputs.size());
+    result["construct_ms"      ] = constructMs;
+    result["layout_ms"         ] = layoutMs;
+    result["paint_ms"          ] = paintMs;
+    result["ticks"             ] = ticks;
+    result["sim_ms"            ] = simMs;
+    result["ticks_per_sec"     ] = 1000.0*ticks/simMs;
+    result["gate_evals_per_sec"] = 1000.0*double(ticks)*double(ng)/simMs;
+    result["peak_rss_kb"       ] = double(peakRSS());
+
+    // hardware counters per evaluation (gates, fused ops or AIG ands executed)
+    if (schem->isPerf()) {
+      using Counter = CQSchem::PerfCounters::Counter;
+
+      const auto &counters = schem->perfCounters();
+
+      double evals = std::max(double(schem->perfEvals()), 1.0);
+
+      for (int i = 0; i < CQSchem::PerfCounters::numCounters; ++i) {
+        auto counter = Counter(i);
+
+        if (! counters.isAvailable(counter))
+          continue;
+
+        result[QString(CQSchem::PerfCounters::counterName(counter)) + "_per_eval"] =
+          double(counters.value(counter))/evals;
+      }
+
+      double cycles = double(counters.value(Counter::CYCLES));
+
+      if (cycles > 0.0)
+        result["ipc"] = double(counters.value(Counter::INSTRUCTIONS))/cycles;
+    }
+
+    delete window;
+  }
+
+  return result;
+}
+
+// compare results of requested circuits against baseline file, returns number of
+// regressions (-1 on error or if any result has no baseline metrics to compare)
+static int
+compareBaseline(const QJsonObject &results, const std::vector<std::string> &names,
+                const QString &filename, double threshold)
+{
+  QFile file(filename);
+
+  if (! file.open(QIODevice::ReadOnly)) {
+    std::cerr << "Failed to read baseline '" << filename.toStdString() << "'\n";
+    return -1;
+  }
+
+  QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+
+  if (! doc.isObject()) {
+    std::cerr << "Invalid baseline '" << filename.toStdString() << "'\n";
+    return -1;
+  }
+
+  QJsonObject baseline = doc.object();
+
+  for (const auto &option : { "optimize", "aig" }) {
+    if (baseline.value(option) != results.value(option))
+      std::cerr << "Warning: baseline '" << option << "' option differs\n";
+  }
+
+  //---
+
+  // metric, true if larger value is better, min absolute change considered
+  struct Metric {
+    const char* name;
+    bool        higher;
+    double      minDelta;
+  };
+
+  static const Metric metrics[] = {
+    { "construct_ms" , false, 0.5 },
+    { "layout_ms"    , false, 0.5 },
+    { "paint_ms"     , false, 0.5 },
+    { "ticks_per_sec", true , 0.0 },
+  };
+
+  QJsonObject baseBenchmarks;
+
+  for (const auto &value : baseline["benchmarks"].toArray()) {
+    QJsonObject benchmark = value.toObject();
+
+    baseBenchmarks[benchmark["name"].toString()] = benchmark;
+  }
+
+  int numRegressions = 0;
+  int numUnchecked   = 0;
+
+  QJsonObject resultBenchmarks;
+
+  for (const auto &value : results["benchmarks"].toArray()) {
+    QJsonObject benchmark = value.toObject();
+
+    QString name = benchmark["name"].toString();
+
+    resultBenchmarks[name] = benchmark;
+
+    QJsonObject baseBenchmark = baseBenchmarks[name].toObject();
+
+    int numCompared = 0;
+
+    for (const auto &metric : metrics) {
+      if (! baseBenchmark.contains(metric.name) || ! benchmark.contains(metric.name))
+        continue;
+
+      double base    = baseBenchmark[metric.name].toDouble();
+      double current = benchmark    [metric.name].toDouble();
+
+      if (base <= 0.0)
+        continue;
+
+      ++numCompared;
+
+      // percentage worse than baseline (negative if better)
+      double worse = 100.0*(metric.higher ? base - current : current - base)/base;
+
+      bool regressed = (worse > threshold && std::abs(current - base) > metric.minDelta);
+
+      std::cerr << name.toStdString() << " " << metric.name << ": " << current <<
+                   " (baseline " << base << ", " << (worse > 0.0 ? "+" : "") << worse <<
+                   "% worse)" << (regressed ? " REGRESSION" : "") << "\n";
+
+      if (regressed)
+        ++numRegressions;
+    }
+
+    if (numCompared == 0) {
+      std::cerr << name.toStdString() << ": no baseline metrics to compare\n";
+
+      ++numUnchecked;
+    }
+  }
+
+  // requested baseline circuits which failed to build count as regressions
+  for (const auto &name : names) {
+    QString qname(name.c_str());
+
+    if (! baseBenchmarks.contains(qname) || resultBenchmarks.contains(qname))
+      continue;
+
+    std::cerr << name << ": failed to build REGRESSION\n";
+
+    ++numRegressions;
+  }
+
+  if (numUnchecked > 0) {
+    std::cerr << numUnchecked << " circuit(s) not checked against baseline '" <<
+                 filename.toStdString() << "' (refresh with -save_baseline)\n";
+    return -1;
+  }
+
+  return numRegressions;
+}
+
+int
+main(int argc, char **argv)
+{
+  // no display needed
+  if (! getenv("QT_QPA_PLATFORM"))
+    setenv("QT_QPA_PLATFORM", "offscreen", 1);
+
+  QApplication app(argc, argv);
+
+  //---
+
+  Options options;
+
+  int     seed      = 1;
+  double  threshold = 10.0;
+  QString baselineFile, saveBaselineFile;
+
+  std::vector<std::string> names;
+
+  for (int i = 1; i < argc; ++i) {
+    if (argv[i][0] == '-') {
+      std::string arg = &argv[i][1];
+
+      if      (arg == "ticks")
+        options.maxTicks = (i < argc - 1 ? std::max(atoi(argv[++i]), 1) : options.maxTicks);
+      else if (arg == "seconds")
+        options.seconds = (i < argc - 1 ? atof(argv[++i]) : options.seconds);
+      else if (arg == "repeat")
+        options.repeat = (i < argc - 1 ? std::max(atoi(argv[++i]), 1) : options.repeat);
+      else if (arg == "seed")
+        seed = (i < argc - 1 ? atoi(argv[++i]) : seed);
+      else if (arg == "optimize")
+        options.optimize = true;
+      else if (arg == "aig")
+        options.aig = true;
+      else if (arg == "perf")
+        options.perf = true;
+      else if (arg == "baseline")
+        baselineFile = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "save_baseline")
+        saveBaselineFile = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "threshold")
+        threshold = (i < argc - 1 ? atof(argv[++i]) : threshold);
+      else
+        std::cerr << "Invalid option '" << argv[i] << "'\n";
+    }
+    else
+      names.push_back(argv[i]);
+  }
+
+  if (names.empty())
+    names = { "build_adder8", "build_alu", "build_ram256", "build_ram65536", "build_control5" };
+
+  //---
+
+  std::mt19937 rng(static_cast<unsigned>(seed));
+
+  QJsonArray benchmarks;
+
+  int numFailed = 0;
+
+  for (const auto &name : names) {
+    QJsonObject result = runBenchmark(name, options, rng);
+
+    if (result.isEmpty()) {
+      std::cerr << "Invalid gate '" << name << "'\n";
+
+      ++numFailed;
+
+      continue;
+    }
+
+    benchmarks.append(result);
+  }
+
+  QJsonObject results;
+
+  results["optimize"  ] = options.optimize;
+  results["aig"       ] = options.aig;
+  results["benchmarks"] = benchmarks;
+
+  QByteArray json = QJsonDocument(results).toJson(QJsonDocument::Indented);
+
+  std::cout << json.constData();
+
+  //---
+
+  if (saveBaselineFile != "") {
+    QFile file(saveBaselineFile);
+
+    if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size())
+      std::cerr << "Failed to write baseline '" << saveBaselineFile.toStdString() << "'\n";
+  }
+
+  if (baselineFile != "") {
+    int numRegressions = compareBaseline(results, names, baselineFile, threshold);
+
+    if (numRegressions != 0) {
+      if (numRegressions > 0)
+        std::cerr << numRegressions << " regression(s) over " << threshold << "%\n";
+
+      return 1;
+    }
+  }
+
+  return (numFailed > 0 ? 1 : 0);
+}
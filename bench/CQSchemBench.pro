@@ -0,0 +1,41 @@
+TEMPLATE = app
+
+TARGET = CQSchemBench
+
+QT += widgets svg
+
+DEPENDPATH += .
+
+QMAKE_CXXFLAGS += \
+-std=c++17 \
+
+MOC_DIR = .moc
+
+CONFIG += c++17
+
+# schematic code without its GUI main
+DEFINES += CQSCHEM_NO_MAIN
+
+SOURCES += \
+CQSchemBench.cpp \
+../src/CQSchem.cpp \
+
+HEADERS += \
+../src/CQSchem.h \
+
+DESTDIR     = ../bin
+OBJECTS_DIR = ../obj/bench
+
+INCLUDEPATH += \
+. \
+../src \
+../include \
+../../CQUtil/include \
+../../CUtil/include \
+../../CMath/include \
+../../COS/include \
+
+unix:LIBS += \
+-L../lib \
+-L../../CQUtil/lib \
+-lCQUtil \
@@ -0,0 +1,240 @@
+#include <CQSchem.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+
+// Gate::exec microbenchmark.
+//
+// Constructs each gate class standalone with its ports bound to dummy connections and
+// measures ns per exec() with random input patterns (outputs changing) and with fixed
+// inputs (outputs unchanged). Results are written to stdout as JSON.
+//
+// usage: CQSchemGateBench [-iterations <n>] [-seed <n>] [<class_name> ...]
+
+using namespace CQSchem;
+
+struct GateFactory {
+  using Create = std::function<Gate *()>;
+
+  const char* name;
+  Create      create;
+};
+
+using GateFactories = std::vector<GateFactory>;
+
+template<typename T>
+static GateFactory
+gateFactory(const char *name)
+{
+  return GateFactory{name, []() -> Gate * { return new T("g"); }};
+}
+
+static GateFactories
+gateFactories()
+{
+  GateFactories factories;
+
+  factories.push_back(gateFactory<NandGate       >("NandGate"       ));
+  factories.push_back(gateFactory<NotGate        >("NotGate"        ));
+  factories.push_back(gateFactory<AndGate        >("AndGate"        ));
+  factories.push_back(gateFactory<And3Gate       >("And3Gate"       ));
+  factories.push_back(gateFactory<And4Gate       >("And4Gate"       ));
+  factories.push_back(gateFactory<And8Gate       >("And8Gate"       ));
+  factories.push_back(gateFactory<OrGate         >("OrGate"         ));
+  factories.push_back(gateFactory<Or8Gate        >("Or8Gate"        ));
+  factories.push_back(gateFactory<XorGate        >("XorGate"        ));
+  factories.push_back(gateFactory<MemoryGate     >("MemoryGate"     ));
+  factories.push_back(gateFactory<Memory8Gate    >("Memory8Gate"    ));
+  factories.push_back(gateFactory<EnablerGate    >("EnablerGate"    ));
+  factories.push_back(gateFactory<RegisterGate   >("RegisterGate"   ));
+  factories.push_back(gateFactory<Decoder4Gate   >("Decoder4Gate"   ));
+  factories.push_back(gateFactory<Decoder8Gate   >("Decoder8Gate"   ));
+  factories.push_back(gateFactory<Decoder16Gate  >("Decoder16Gate"  ));
+  factories.push_back(gateFactory<Decoder256Gate >("Decoder256Gate" ));
+  factories.push_back(gateFactory<LShiftGate     >("LShiftGate"     ));
+  factories.push_back(gateFactory<RShiftGate     >("RShiftGate"     ));
+  factories.push_back(gateFactory<InverterGate   >("InverterGate"   ));
+  factories.push_back(gateFactory<AnderGate      >("AnderGate"      ));
+  factories.push_back(gateFactory<OrerGate       >("OrerGate"       ));
+  factories.push_back(gateFactory<XorerGate      >("XorerGate"      ));
+  factories.push_back(gateFactory<AdderGate      >("AdderGate"      ));
+  factories.push_back(gateFactory<Adder8Gate     >("Adder8Gate"     ));
+  factories.push_back(gateFactory<ComparatorGate >("ComparatorGate" ));
+  factories.push_back(gateFactory<Comparator8Gate>("Comparator8Gate"));
+  factories.push_back(gateFactory<Bus0Gate       >("Bus0Gate"       ));
+  factories.push_back(gateFactory<Bus1Gate       >("Bus1Gate"       ));
+  factories.push_back(gateFactory<AluGate        >("AluGate"        ));
+  factories.push_back(gateFactory<ClkESGate      >("ClkESGate"      ));
+  factories.push_back(gateFactory<StepperGate    >("StepperGate"    ));
+
+  factories.push_back(GateFactory{"ClkGate", []() -> Gate * {
+    auto *gate = new ClkGate("g"); gate->setDelay(1); gate->setCycle(2); return gate; }});
+  factories.push_back(GateFactory{"RamArrayGate", []() -> Gate * {
+    return new RamArrayGate("g", 16, 16); }});
+
+  return factories;
+}
+
+int
+main(int argc, char **argv)
+{
+  int iterations = 1000000;
+  int seed       = 1;
+
+  std::vector<std::string> names;
+
+  for (int i = 1; i < argc; ++i) {
+    if (argv[i][0] == '-') {
+      std::string arg = &argv[i][1];
+
+      if      (arg == "iterations")
+        iterations = (i < argc - 1 ? std::max(atoi(argv[++i]), 1) : iterations);
+      else if (arg == "seed")
+        seed = (i < argc - 1 ? atoi(argv[++i]) : seed);
+      else
+        std::cerr << "Invalid option '" << argv[i] << "'\n";
+    }
+    else
+      names.push_back(argv[i]);
+  }
+
+  //---
+
+  // gates, ports and connections are allocated from current arena
+  ObjArena arena;
+
+  ObjArena::setCurrent(&arena);
+
+  using Clock = std::chrono::steady_clock;
+
+  auto ns = [](const Clock::time_point &t1, const Clock::time_point &t2) {
+    return std::chrono::duration<double, std::nano>(t2 - t1).count();
+  };
+
+  std::mt19937 rng(static_cast<unsigned>(seed));
+
+  std::cout << "{\n";
+  std::cout << "  \"iterations\": " << iterations << ",\n";
+  std::cout << "  \"benchmarks\": [";
+
+  int nb = 0;
+
+  for (const auto &factory : gateFactories()) {
+    if (! names.empty() && std::find(names.begin(), names.end(), factory.name) == names.end())
+      continue;
+
+    Gate *gate = factory.create();
+
+    // bind each port to its own dummy connection
+    std::vector<Connection *> inputs, outputs;
+
+    int ni = int(gate->inputs ().size());
+    int no = int(gate->outputs().size());
+
+    for (int i = 0; i < ni; ++i) {
+      auto *connection = new Connection(QString("i%1").arg(i));
+
+      gate->connectInput(i, connection);
+
+      inputs.push_back(connection);
+    }
+
+    for (int i = 0; i < no; ++i) {
+      auto *connection = new Connection(QString("o%1").arg(i));
+
+      gate->connectOutput(i, connection);
+
+      outputs.push_back(connection);
+    }
+
+    //---
+
+    // random input patterns (reused cyclically)
+    const int np = 1024;
+
+    auto patterns = std::vector<uchar>(uint(np*ni));
+
+    for (auto &b : patterns)
+      b = uchar(rng() & 1);
+
+    auto setInputs = [&](int p) {
+      const uchar *pattern = &patterns[uint((p % np)*ni)];
+
+      for (int i = 0; i < ni; ++i)
+        inputs[uint(i)]->setValue(pattern[i]);
+    };
+
+    // cost of setting inputs (subtracted from random pattern times)
+    auto t1 = Clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+      setInputs(i);
+
+    auto t2 = Clock::now();
+
+    // random inputs
+    long numChanged = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+      setInputs(i);
+
+      if (gate->exec())
+        ++numChanged;
+    }
+
+    auto t3 = Clock::now();
+
+    // fixed inputs (outputs settle after first exec)
+    setInputs(0);
+
+    (void) gate->exec();
+    (void) gate->exec();
+
+    long numUnchanged = 0;
+
+    auto t4 = Clock::now();
+
+    for (int i = 0; i < iterations; ++i) {
+      if (! gate->exec())
+        ++numUnchanged;
+    }
+
+    auto t5 = Clock::now();
+
+    //---
+
+    double setNs       = ns(t1, t2)/iterations;
+    double changedNs   = std::max(ns(t2, t3)/iterations - setNs, 0.0);
+    double unchangedNs = ns(t4, t5)/iterations;
+
+    std::cout << (nb > 0 ? "," : "") << "\n";
+    std::cout << "    {\n";
+    std::cout << "      \"name\": \"" << factory.name << "\",\n";
+    std::cout << "      \"inputs\": " << ni << ",\n";
+    std::cout << "      \"outputs\": " << no << ",\n";
+    std::cout << "      \"set_inputs_ns\": " << setNs << ",\n";
+    std::cout << "      \"random_exec_ns\": " << changedNs << ",\n";
+    std::cout << "      \"random_changed_fraction\": " << double(numChanged)/iterations << ",\n";
+    std::cout << "      \"fixed_exec_ns\": " << unchangedNs << ",\n";
+    std::cout << "      \"fixed_unchanged_fraction\": " << double(numUnchanged)/iterations << "\n";
+    std::cout << "    }";
+
+    ++nb;
+
+    //---
+
+    delete gate;
+
+    for (auto &connection : inputs)
+      delete connection;
+
+    for (auto &connection : outputs)
+      delete connection;
+  }
+
+  std::cout << "\n  ]\n}\n";
+
+  return 0;
+}
@@ -12,10 +12,34 @@
 #include <QMenu>
 #include <QAction>
 #include <QTimer>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
 
 #include <set>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <new>
+#include <typeindex>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
 #include <cassert>
 
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #include <svg/connection_text_svg.h>
 #include <svg/gate_text_svg.h>
 #include <svg/move_connection_svg.h>
@@ -26,13 +50,22 @@
 #include <svg/gate_visible_svg.h>
 #include <svg/placement_group_visible_svg.h>
 #include <svg/collapse_bus_svg.h>
+#include <svg/heatmap_svg.h>
 #include <svg/pause_svg.h>
 #include <svg/play_one_svg.h>
 #include <svg/play_svg.h>
 
+// main excluded when linked into other programs (benchmarks)
+#ifndef CQSCHEM_NO_MAIN
 int
 main(int argc, char **argv)
 {
+  // image render needs no display
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-render_image") == 0 && ! getenv("QT_QPA_PLATFORM"))
+      setenv("QT_QPA_PLATFORM", "offscreen", 1);
+  }
+
   QApplication app(argc, argv);
 
   //---
@@ -47,8 +80,26 @@ main(int argc, char **argv)
 
   //---
 
-  bool test     = false;
-  bool waveform = false;
+  bool test        = false;
+  bool netlistTest = false;
+  bool waveform    = false;
+  int  routeBench  = 0;
+  bool layoutCache = false;
+
+  QString loadNetlist, saveNetlist, importNetlist, exportNetlist;
+  bool    importBench = false;
+  bool    optimize    = false;
+  bool    aig         = false;
+  bool    stats       = false;
+  bool    memory      = false;
+  bool    perf        = false;
+
+  bool    paintProfile = false;
+  QString paintProfileFile;
+
+  QString renderImage;
+  QSize   renderSize(1024, 1024);
+  double  renderZoom = 1.0;
 
   std::vector<std::string> gates;
 
@@ -58,17 +109,71 @@ main(int argc, char **argv)
 
       if      (arg == "test")
         test = true;
+      else if (arg == "netlist_check")
+        netlistTest = true;
       else if (arg == "waveform")
         waveform = true;
+      else if (arg == "route_bench")
+        routeBench = (i < argc - 1 ? std::max(atoi(argv[++i]), 1) : 1);
+      else if (arg == "layout_cache")
+        layoutCache = true;
+      else if (arg == "load_netlist")
+        loadNetlist = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "save_netlist")
+        saveNetlist = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "import_netlist")
+        importNetlist = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "export_netlist")
+        exportNetlist = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "import_bench")
+        importBench = true;
+      else if (arg == "optimize")
+        optimize = true;
+      else if (arg == "aig")
+        aig = true;
+      else if (arg == "stats")
+        stats = true;
+      else if (arg == "memory")
+        memory = true;
+      else if (arg == "perf")
+        perf = true;
+      else if (arg == "paint_profile")
+        paintProfile = true;
+      else if (arg == "paint_profile_file")
+        paintProfileFile = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "render_image")
+        renderImage = (i < argc - 1 ? argv[++i] : "");
+      else if (arg == "render_size") {
+        QStringList strs = QString(i < argc - 1 ? argv[++i] : "").split("x");
+
+        int w = (strs.length() == 2 ? strs[0].toInt() : 0);
+        int h = (strs.length() == 2 ? strs[1].toInt() : 0);
+
+        if (w > 0 && h > 0)
+          renderSize = QSize(w, h);
+        else
+          std::cerr << "Invalid render size '" << argv[i] << "'\n";
+      }
+      else if (arg == "render_zoom")
+        renderZoom = (i < argc - 1 ? std::max(atof(argv[++i]), 1E-3) : renderZoom);
       else
         gates.push_back(arg);
     }
   }
 
-  auto *window = new CQSchem::Window(waveform);
+  auto *window = new CQSchem::Window(waveform, stats);
 
   auto *schem = window->schem();
 
+  schem->setOptimize(optimize);
+  schem->setAig     (aig);
+  schem->setStats   (stats);
+
+  schem->setShowPaintProfile(paintProfile);
+
+  if (perf)
+    schem->setPerf(true);
+
   for (const auto &gate : gates) {
     if (schem->execGate(gate.c_str()))
       continue;
@@ -76,26 +181,88 @@ main(int argc, char **argv)
     std::cerr << "Invalid arg '-" << gate << "'\n";
   }
 
-  schem->place();
+  if (loadNetlist != "" && ! schem->loadNetlist(loadNetlist))
+    std::cerr << "Failed to load netlist '" << loadNetlist.toStdString() << "'\n";
+
+  if (importNetlist != "" && ! schem->importNetlist(importNetlist, importBench))
+    std::cerr << "Failed to import netlist '" << importNetlist.toStdString() << "'\n";
 
-  if (test) {
+  if (saveNetlist != "" && ! schem->saveNetlist(saveNetlist))
+    std::cerr << "Failed to save netlist '" << saveNetlist.toStdString() << "'\n";
+
+  if (exportNetlist != "" && ! schem->exportNetlist(exportNetlist))
+    std::cerr << "Failed to export netlist '" << exportNetlist.toStdString() << "'\n";
+
+  // reuse saved layout and routes for same build if available
+  QString buildName;
+
+  for (const auto &gate : gates)
+    buildName += (buildName != "" ? "_" : "") + QString(gate.c_str());
+
+  if (loadNetlist != "")
+    buildName += (buildName != "" ? "_" : "") + QFileInfo(loadNetlist).baseName();
+
+  if (importNetlist != "")
+    buildName += (buildName != "" ? "_" : "") + QFileInfo(importNetlist).baseName();
+
+  bool layoutCached = (layoutCache && schem->loadLayoutCache(buildName));
+
+  if (! layoutCached)
+    schem->place();
+
+  // save new layout after first full route (or at exit if never drawn)
+  if (layoutCache && ! layoutCached)
+    schem->setSaveLayoutCache(buildName);
+
+  if (memory)
+    schem->printMemory();
+
+  int rc = 0;
+
+  if      (test) {
     schem->exec();
 
     schem->test();
   }
+  else if (netlistTest) {
+    if (! schem->netlistCheck())
+      rc = 1;
+  }
+  else if (routeBench > 0) {
+    schem->routeBench(routeBench);
+  }
+  else if (renderImage != "") {
+    if (! schem->renderImage(renderImage, renderSize, renderZoom))
+      std::cerr << "Failed to write image '" << renderImage.toStdString() << "'\n";
+  }
   else {
     window->show();
 
     app.exec();
   }
+
+  if (stats)
+    schem->printStats();
+
+  if (schem->isPerf())
+    schem->printPerf();
+
+  if (paintProfileFile != "" && ! schem->paintProfile().dump(paintProfileFile))
+    std::cerr << "Failed to write paint profile '" << paintProfileFile.toStdString() << "'\n";
+
+  if (schem->saveLayoutCacheName() != "")
+    schem->saveLayoutCache(schem->saveLayoutCacheName());
+
+  return rc;
 }
+#endif
 
 //------
 
 namespace CQSchem {
 
 Window::
-Window(bool waveform)
+Window(bool waveform, bool stats)
 {
   QVBoxLayout *layout = new QVBoxLayout(this);
   layout->setMargin(0); layout->setSpacing(0);
@@ -113,7 +280,7 @@ Window(bool waveform)
 
   //---
 
-  if (waveform) {
+  if (waveform || stats) {
     splitter_ = new QSplitter(Qt::Vertical);
     splitter_->setObjectName("splitter");
 
@@ -124,7 +291,7 @@ Window(bool waveform)
 
   schem_ = new Schematic(this);
 
-  if (waveform)
+  if (splitter_)
     splitter_->addWidget(schem_);
   else
     layout->addWidget(schem_);
@@ -201,6 +368,11 @@ Window(bool waveform)
                    schem_->isCollapseBus(), "Collapse Bus",
                    SLOT(collapseBusSlot(bool)));
 
+  auto *heatmapButton =
+    addCheckButton("heatmap", "HEATMAP",
+                   schem_->isHeatmap(), "Connection Activity Heatmap",
+                   SLOT(heatmapSlot(bool)));
+
   playButton_  = addToolButton("play" , "PLAY"    , "Play" , SLOT(playSlot()));
   pauseButton_ = addToolButton("pause", "PAUSE"   , "Pause", SLOT(pauseSlot()));
   stepButton_  = addToolButton("step" , "PLAY_ONE", "Step" , SLOT(stepSlot()));
@@ -221,6 +393,8 @@ Window(bool waveform)
 
   controlLayout->addWidget(collapseBusButton);
 
+  controlLayout->addWidget(heatmapButton);
+
   controlLayout->addWidget(playButton_);
   controlLayout->addWidget(pauseButton_);
   controlLayout->addWidget(stepButton_);
@@ -235,6 +409,12 @@ Window(bool waveform)
     splitter_->addWidget(waveform_);
   }
 
+  if (stats) {
+    statsPanel_ = new StatsPanel(schem_);
+
+    splitter_->addWidget(statsPanel_);
+  }
+
   //---
 
   QFrame *statusFrame = new QFrame;
@@ -365,6 +545,15 @@ collapseBusSlot(bool b)
   redraw();
 }
 
+void
+Window::
+heatmapSlot(bool b)
+{
+  schem_->setHeatmap(b);
+
+  redraw();
+}
+
 void
 Window::
 playSlot()
@@ -418,6 +607,319 @@ sizeHint() const
 
 //------
 
+// approximate heap bytes of string (shared data header and utf16 chars)
+static size_t
+stringBytes(const QString &str)
+{
+  return (! str.isNull() ? 24 + 2*size_t(str.capacity() + 1) : 0);
+}
+
+//---
+
+struct NameTableData {
+  using Names   = std::deque<QString>;
+  using NameInd = QHash<QString, int>;
+
+  Names   names;
+  NameInd nameInd;
+
+  NameTableData() {
+    // index 0 is empty name
+    names.push_back("");
+
+    nameInd[""] = 0;
+  }
+};
+
+static NameTableData &
+nameTableData()
+{
+  static NameTableData data;
+
+  return data;
+}
+
+int
+NameTable::
+intern(const QString &name)
+{
+  auto &data = nameTableData();
+
+  int ind = data.nameInd.value(name, -1);
+
+  if (ind < 0) {
+    ind = int(data.names.size());
+
+    data.names.push_back(name);
+
+    data.nameInd[name] = ind;
+  }
+
+  return ind;
+}
+
+const QString &
+NameTable::
+name(int ind)
+{
+  return nameTableData().names[uint(ind)];
+}
+
+int
+NameTable::
+numNames()
+{
+  return int(nameTableData().names.size());
+}
+
+size_t
+NameTable::
+numBytes()
+{
+  auto &data = nameTableData();
+
+  // deque entry, hash node (key copy shares string data) and string data
+  size_t n = data.names.size()*(2*sizeof(QString) + sizeof(int) + 2*sizeof(void *));
+
+  for (const auto &name : data.names)
+    n += stringBytes(name);
+
+  return n;
+}
+
+//------
+
+ObjArena *ObjArena::current_ = nullptr;
+
+ObjArena::
+~ObjArena()
+{
+  for (auto &chunk : chunks_)
+    ::operator delete(chunk, std::align_val_t(chunkSize));
+
+  if (current_ == this)
+    current_ = nullptr;
+}
+
+void *
+ObjArena::
+alloc(size_t size)
+{
+  size = (size + align - 1) & ~(align - 1);
+
+  if (size > maxSize)
+    return ::operator new(size);
+
+  auto ind = size/align;
+
+  if (ind >= pools_.size())
+    pools_.resize(ind + 1);
+
+  Pool &pool = pools_[ind];
+
+  ++numLive_;
+
+  // reuse deleted object
+  if (pool.freeList) {
+    FreeObj *obj = pool.freeList;
+
+    pool.freeList = obj->next;
+
+    return obj;
+  }
+
+  // start new chunk for pool if full (first align bytes store owning arena)
+  if (pool.ptr + size > pool.end) {
+    char *chunk = static_cast<char *>(::operator new(chunkSize, std::align_val_t(chunkSize)));
+
+    *reinterpret_cast<ObjArena **>(chunk) = this;
+
+    chunks_.push_back(chunk);
+
+    pool.ptr = chunk + align;
+    pool.end = chunk + chunkSize;
+  }
+
+  void *p = pool.ptr;
+
+  pool.ptr += size;
+
+  return p;
+}
+
+void
+ObjArena::
+free(void *p, size_t size)
+{
+  if (! p)
+    return;
+
+  size = (size + align - 1) & ~(align - 1);
+
+  if (size > maxSize) {
+    ::operator delete(p);
+    return;
+  }
+
+  auto ind = size/align;
+
+  assert(ind < pools_.size() && numLive_ > 0);
+
+  Pool &pool = pools_[ind];
+
+  FreeObj *obj = static_cast<FreeObj *>(p);
+
+  obj->next = pool.freeList;
+
+  pool.freeList = obj;
+
+  --numLive_;
+}
+
+void
+ObjArena::
+freeObj(void *p, size_t size)
+{
+  if (! p)
+    return;
+
+  size_t size1 = (size + align - 1) & ~(align - 1);
+
+  if (size1 > maxSize) {
+    ::operator delete(p);
+    return;
+  }
+
+  auto *chunk = reinterpret_cast<char *>(reinterpret_cast<uintptr_t>(p) & ~(chunkSize - 1));
+
+  ObjArena *arena = *reinterpret_cast<ObjArena **>(chunk);
+
+  assert(arena);
+
+  arena->free(p, size);
+}
+
+void
+ObjArena::
+release()
+{
+  assert(numLive_ == 0);
+
+  for (auto &chunk : chunks_)
+    ::operator delete(chunk, std::align_val_t(chunkSize));
+
+  chunks_.clear();
+  pools_ .clear();
+}
+
+//------
+
+void
+SimAig::
+clear()
+{
+  inputs_ .clear();
+  ands_   .clear();
+  outputs_.clear();
+  values_ .clear();
+  andInd_ .clear();
+
+  numMerged_ = 0;
+
+  // constant false node
+  (void) addNode();
+}
+
+uint32_t
+SimAig::
+addInput(Connection *connection)
+{
+  Input input;
+
+  input.node       = addNode();
+  input.connection = connection;
+
+  inputs_.push_back(input);
+
+  return 2*input.node;
+}
+
+uint32_t
+SimAig::
+addAnd(uint32_t l0, uint32_t l1)
+{
+  if (l0 > l1)
+    std::swap(l0, l1);
+
+  // fold constant and trivial inputs
+  if (l0 == constLit(false)) return constLit(false);
+  if (l0 == constLit(true )) return l1;
+  if (l0 == l1             ) return l0;
+  if (l0 == notLit(l1)     ) return constLit(false);
+
+  // reuse existing node with same inputs
+  uint64_t key = (uint64_t(l0) << 32) | l1;
+
+  auto p = andInd_.find(key);
+
+  if (p != andInd_.end()) {
+    ++numMerged_;
+
+    return 2*(*p).second;
+  }
+
+  And a;
+
+  a.node = addNode();
+  a.l0   = l0;
+  a.l1   = l1;
+
+  ands_.push_back(a);
+
+  andInd_[key] = a.node;
+
+  return 2*a.node;
+}
+
+void
+SimAig::
+addOutput(Port *port, uint32_t l)
+{
+  Output output;
+
+  output.port = port;
+  output.l    = l;
+
+  outputs_.push_back(output);
+}
+
+bool
+SimAig::
+exec()
+{
+  for (const auto &input : inputs_)
+    values_[input.node] = input.connection->getValue();
+
+  for (const auto &a : ands_)
+    values_[a.node] = (value(a.l0) && value(a.l1));
+
+  bool changed = false;
+
+  for (const auto &output : outputs_) {
+    bool b = value(output.l);
+
+    if (b != output.port->getValue()) {
+      output.port->setValue(b);
+
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+//------
+
 Schematic::
 Schematic(Window *window) :
  window_(window)
@@ -430,6 +932,8 @@ Schematic(Window *window) :
 
   //---
 
+  ObjArena::setCurrent(&arena_);
+
   placementGroup_ = new PlacementGroup;
 
   debugConnect_ = (getenv("CQSCHEM_DEBUG_CONNECT") != nullptr);
@@ -438,6 +942,10 @@ Schematic(Window *window) :
 Schematic::
 ~Schematic()
 {
+  delete memoryPanel_;
+
+  delete routeCacheFile_;
+
   clear();
 }
 
@@ -460,6 +968,19 @@ clear()
 
   connections_.clear();
 
+  routeChannels_.clear();
+
+  simOps_.clear();
+  simAig_.clear();
+
+  simValid_ = false;
+
+  resetToggles();
+
+  // all arena objects destroyed so free memory in bulk
+  if (arena_.numLive() == 0)
+    arena_.release();
+
   delete placementGroup_;
 
   placementGroup_ = new PlacementGroup;
@@ -484,6 +1005,10 @@ bool
 Schematic::
 execGate(PlacementGroup *parentGroup, const QString &name)
 {
+  Trace::Scope trace("build", name);
+
+  ObjArena::CurrentScope arenaScope(&arena_);
+
   PlacementGroup *oldPlacementGroup = placementGroup_;
 
   placementGroup_ = parentGroup;
@@ -522,6 +1047,8 @@ execGate(PlacementGroup *parentGroup, const QString &name)
   else if (name == "alu"        ) addAluGate();
   else if (name == "stepper"    ) addStepperGate();
   else if (name == "clk_es"     ) addClkESGate();
+  else if (name == "ram_array16" ) addRamArrayGate(16);
+  else if (name == "ram_array256") addRamArrayGate(256);
 
   else if (name.startsWith("clk")) {
     QStringList strs = name.mid(3).split(':');
@@ -568,6 +1095,13 @@ execGate(PlacementGroup *parentGroup, const QString &name)
   else if (name == "build_bus1"       ) buildBus1();
   else if (name == "build_ram256"     ) buildRam256();
   else if (name == "build_ram65536"   ) buildRam65536();
+
+  else if (name == "build_ram256_cells"  ) buildRam256  (/*lazyCells*/false);
+  else if (name == "build_ram65536_cells") buildRam65536(/*lazyCells*/false);
+
+  else if (name == "build_ram_cells16"   ) buildRamCells(16);
+  else if (name == "build_ram_cells256"  ) buildRamCells(256);
+
   else if (name == "build_alu"        ) buildAlu();
   else if (name == "build_clk"        ) buildClk();
   else if (name == "build_clk_es"     ) buildClkES();
@@ -1301,7 +1835,7 @@ addDecoder256Gate()
 
     Connection *coni = addPlacementConn(iname);
 
-    gate->connect(iname, coni);
+    gate->connectInput(i, coni);
   }
 
   for (int i = 0; i < 256; ++i) {
@@ -1309,7 +1843,7 @@ addDecoder256Gate()
 
     Connection *cono = addPlacementConn(oname);
 
-    gate->connect(oname, cono);
+    gate->connectOutput(i, cono);
   }
 }
 
@@ -3900,7 +4434,7 @@ buildBus1()
 
 void
 Schematic::
-buildRam256()
+buildRam256(bool lazyCells)
 {
   PlacementGroup *placementGroup =
     addPlacementGroup(PlacementGroup::Placement::GRID, 2, 3);
@@ -3958,9 +4492,9 @@ buildRam256()
     rgate->connect(oname, out);
 
     if (i < 4)
-      hdec->connect(Decoder16Gate::iname(i    ), out);
+      hdec->connectInput(i    , out);
     else
-      vdec->connect(Decoder16Gate::iname(i - 4), out);
+      vdec->connectInput(i - 4, out);
 
     ibus->addConnection(in , i);
 
@@ -3979,8 +4513,8 @@ buildRam256()
     hout[i] = addPlacementConn(honame);
     vout[i] = addPlacementConn(voname);
 
-    hdec->connect(honame, hout[i]);
-    vdec->connect(voname, vout[i]);
+    hdec->connectOutput(i, hout[i]);
+    vdec->connectOutput(i, vout[i]);
   }
 
   rgate->connect("s", addPlacementConn("sa"));
@@ -4002,65 +4536,20 @@ buildRam256()
 
   //---
 
+  if (lazyCells) {
+    addRamArrayGate(placementGroup, 16, hout, vout, s, e, bus);
+    return;
+  }
+
   PlacementGroup *placementGroup1 =
     placementGroup->addPlacementGroup(PlacementGroup::Placement::GRID, 16, 16, 0, 2);
 
-  for (int r = 0; r < 16; ++r) {
-    for (int c = 0; c < 16; ++c) {
-      PlacementGroup *placementGroup2 =
-        placementGroup1->addPlacementGroup(PlacementGroup::Placement::GRID, 2, 3, 15 - r, c);
-
-      //---
-
-      AndGate *xgate = addGateT<AndGate>(QString("X_%1_%2").arg(r).arg(c));
-
-      xgate->connect("a", hout[r]);
-      xgate->connect("b", vout[c]);
-
-      Connection *t1 = addPlacementConn("t1");
-
-      xgate->connect("c", t1);
-
-      AndGate *agate = addGateT<AndGate>(QString("X1_%1_%2").arg(r).arg(c));
-      AndGate *bgate = addGateT<AndGate>(QString("X1_%1_%2").arg(r).arg(c));
-
-      RegisterGate *rgate = addGateT<RegisterGate>(QString("R_%1_%2").arg(r).arg(c));
-
-      Connection *t2 = addPlacementConn("t2");
-      Connection *t3 = addPlacementConn("t3");
-
-      agate->connect("a", t1);
-      agate->connect("b", s);
-      agate->connect("c", t2);
-
-      bgate->connect("a", t1);
-      bgate->connect("b", e);
-      bgate->connect("c", t3);
-
-      rgate->connect("s", t2);
-      rgate->connect("e", t3);
-
-      for (int i = 0; i < 8; ++i) {
-        QString iname = RegisterGate::iname(i);
-        QString oname = RegisterGate::oname(i);
-
-        rgate->connect(iname, bus[i]);
-        rgate->connect(oname, bus[i]);
-      }
-
-      //---
-
-      placementGroup2->addGate(xgate, 1, 0);
-      placementGroup2->addGate(agate, 1, 1);
-      placementGroup2->addGate(bgate, 0, 1);
-      placementGroup2->addGate(rgate, 0, 2, 2, 1);
-    }
-  }
+  addRamCells(placementGroup1, 16, hout, vout, s, e, bus);
 }
 
 void
 Schematic::
-buildRam65536()
+buildRam65536(bool lazyCells)
 {
   PlacementGroup *placementGroup =
     addPlacementGroup(PlacementGroup::Placement::GRID, 3, 3);
@@ -4126,9 +4615,9 @@ buildRam65536()
     rgate1->connect(oname, out2);
 
     if (i < 4)
-      hdec->connect(Decoder256Gate::iname(i), out1);
+      hdec->connectInput(i, out1);
     else
-      vdec->connect(Decoder256Gate::iname(i), out2);
+      vdec->connectInput(i, out2);
 
     ibus->addConnection(in, i);
 
@@ -4145,8 +4634,8 @@ buildRam65536()
     hout[i] = addPlacementConn(honame);
     vout[i] = addPlacementConn(voname);
 
-    hdec->connect(honame, hout[i]);
-    vdec->connect(voname, vout[i]);
+    hdec->connectOutput(i, hout[i]);
+    vdec->connectOutput(i, vout[i]);
   }
 
   rgate0->connect("s", addPlacementConn("s0"));
@@ -4169,34 +4658,95 @@ buildRam65536()
 
   //---
 
+  if (lazyCells) {
+    addRamArrayGate(placementGroup, 256, hout, vout, s, e, bus);
+    return;
+  }
+
   PlacementGroup *placementGroup1 =
     placementGroup->addPlacementGroup(PlacementGroup::Placement::GRID, 256, 256, 0, 2);
 
-  for (int r = 0; r < 256; ++r) {
-    //std::cerr << "Row: " << r << "\n";
+  addRamCells(placementGroup1, 256, hout, vout, s, e, bus);
+}
+
+void
+Schematic::
+buildRamCells(int n)
+{
+  // gate level cells for expanded ram cell array (connections named from array ports)
+  PlacementGroup *placementGroup =
+    addPlacementGroup(PlacementGroup::Placement::GRID, n, n);
+
+  placementGroup->setCollapseName(QString("ram_array%1").arg(n));
+
+  auto addPlacementConn = [&](const QString &name) {
+    Connection *conn = addConnection(name);
+
+    placementGroup->addConnection(conn);
+
+    return conn;
+  };
+
+  //---
+
+  assert(n <= 256);
+
+  Connection *hout[256], *vout[256];
+
+  for (int i = 0; i < n; ++i) {
+    hout[i] = addPlacementConn(RamArrayGate::hname(i));
+    vout[i] = addPlacementConn(RamArrayGate::vname(i));
+  }
+
+  Connection *s = addPlacementConn("s");
+  Connection *e = addPlacementConn("e");
+
+  Connection *bus[8];
+
+  for (int i = 0; i < 8; ++i)
+    bus[i] = addPlacementConn(RamArrayGate::iname(i));
+
+  //---
+
+  addRamCells(placementGroup, n, hout, vout, s, e, bus);
+}
+
+void
+Schematic::
+addRamCells(PlacementGroup *placementGroup, int n, Connection **hout,
+            Connection **vout, Connection *s, Connection *e, Connection **bus)
+{
+  for (int r = 0; r < n; ++r) {
+    for (int c = 0; c < n; ++c) {
+      PlacementGroup *placementGroup1 =
+        placementGroup->addPlacementGroup(PlacementGroup::Placement::GRID, 2, 3, n - 1 - r, c);
 
-    for (int c = 0; c < 256; ++c) {
-      PlacementGroup *placementGroup2 =
-        placementGroup1->addPlacementGroup(PlacementGroup::Placement::GRID, 2, 3, 255 - r, c);
+      // gate names qualified by cell index (X_<r>_<c>) on demand
+      placementGroup1->setIndexName(r, c);
 
       //---
 
-      AndGate *xgate = addGateT<AndGate>(QString("X_%1_%2").arg(r).arg(c));
+      AndGate *xgate = addGateT<AndGate>("X");
 
       xgate->connect("a", hout[r]);
       xgate->connect("b", vout[c]);
 
-      Connection *t1 = addPlacementConn("t1");
+      Connection *t1 = addConnection("t1");
+
+      placementGroup->addConnection(t1);
 
       xgate->connect("c", t1);
 
-      AndGate *agate = addGateT<AndGate>(QString("X1_%1_%2").arg(r).arg(c));
-      AndGate *bgate = addGateT<AndGate>(QString("X1_%1_%2").arg(r).arg(c));
+      AndGate *agate = addGateT<AndGate>("X1");
+      AndGate *bgate = addGateT<AndGate>("X1");
 
-      RegisterGate *rgate = addGateT<RegisterGate>(QString("R_%1_%2").arg(r).arg(c));
+      RegisterGate *rgate = addGateT<RegisterGate>("R");
 
-      Connection *t2 = addPlacementConn("t2");
-      Connection *t3 = addPlacementConn("t3");
+      Connection *t2 = addConnection("t2");
+      Connection *t3 = addConnection("t3");
+
+      placementGroup->addConnection(t2);
+      placementGroup->addConnection(t3);
 
       agate->connect("a", t1);
       agate->connect("b", s);
@@ -4210,21 +4760,148 @@ buildRam65536()
       rgate->connect("e", t3);
 
       for (int i = 0; i < 8; ++i) {
-        QString iname = RegisterGate::iname(i);
-        QString oname = RegisterGate::oname(i);
-
-        rgate->connect(iname, bus[i]);
-        rgate->connect(oname, bus[i]);
+        rgate->connectInput (i, bus[i]);
+        rgate->connectOutput(i, bus[i]);
       }
 
       //---
 
-      placementGroup2->addGate(xgate, 0, 0);
-      placementGroup2->addGate(agate, 0, 1);
-      placementGroup2->addGate(bgate, 1, 1);
-      placementGroup2->addGate(rgate, 1, 2, 2, 1);
+      placementGroup1->addGate(xgate, 1, 0);
+      placementGroup1->addGate(agate, 1, 1);
+      placementGroup1->addGate(bgate, 0, 1);
+      placementGroup1->addGate(rgate, 0, 2, 2, 1);
+    }
+  }
+}
+
+void
+Schematic::
+addRamArrayGate(int n)
+{
+  // collapsed ram cell array (connections named as in buildRamCells)
+  PlacementGroup *placementGroup =
+    addPlacementGroup(PlacementGroup::Placement::HORIZONTAL);
+
+  placementGroup->setExpandName(QString("build_ram_cells%1").arg(n));
+
+  auto addPlacementConn = [&](const QString &name) {
+    Connection *conn = addConnection(name);
+
+    placementGroup->addConnection(conn);
+
+    return conn;
+  };
+
+  //---
+
+  auto *gate = new RamArrayGate("RAM", n, n);
+
+  gate->setSchem(this);
+
+  addGate(gate);
+
+  for (int r = 0; r < n; ++r)
+    gate->connectInput(r, addPlacementConn(RamArrayGate::hname(r)));
+
+  for (int c = 0; c < n; ++c)
+    gate->connectInput(n + c, addPlacementConn(RamArrayGate::vname(c)));
+
+  for (int i = 0; i < 8; ++i) {
+    Connection *conn = addPlacementConn(RamArrayGate::iname(i));
+
+    gate->connectInput (2*n + i, conn);
+    gate->connectOutput(i, conn);
+  }
+
+  gate->connectInput(2*n + 8, addPlacementConn("s"));
+  gate->connectInput(2*n + 9, addPlacementConn("e"));
+
+  placementGroup->addGate(gate);
+}
+
+void
+Schematic::
+copyRamCellState(PlacementGroup *oldGroup, PlacementGroup *newGroup)
+{
+  // copy register bits between ram cell array gate and gate level cells
+  // (cell register gates are in row major order, see addRamCells)
+  auto findGates = [](PlacementGroup *placementGroup, RamArrayGate* &array,
+                      std::vector<RegisterGate *> &registers) {
+    Gates gates;
+
+    placementGroup->hierGates(gates);
+
+    for (auto &gate : gates) {
+      auto *array1    = dynamic_cast<RamArrayGate *>(gate);
+      auto *register1 = dynamic_cast<RegisterGate *>(gate);
+
+      if      (array1)
+        array = array1;
+      else if (register1)
+        registers.push_back(register1);
     }
+  };
+
+  RamArrayGate *oldArray = nullptr, *newArray = nullptr;
+
+  std::vector<RegisterGate *> oldRegisters, newRegisters;
+
+  findGates(oldGroup, oldArray, oldRegisters);
+  findGates(newGroup, newArray, newRegisters);
+
+  if      (oldArray && ! newArray) {
+    auto n = uint(oldArray->numRows()*oldArray->numColumns());
+
+    if (newRegisters.size() != n)
+      return;
+
+    for (uint i = 0; i < n; ++i)
+      newRegisters[i]->setStateBits(oldArray->cellState(int(i)));
+  }
+  else if (newArray && ! oldArray) {
+    auto n = uint(newArray->numRows()*newArray->numColumns());
+
+    if (oldRegisters.size() != n)
+      return;
+
+    for (uint i = 0; i < n; ++i)
+      newArray->setCellState(int(i), oldRegisters[i]->stateBits());
+  }
+}
+
+void
+Schematic::
+addRamArrayGate(PlacementGroup *placementGroup, int n, Connection **hout,
+                Connection **vout, Connection *s, Connection *e, Connection **bus)
+{
+  // single gate for all cells (same connections as separate cell gates) in group
+  // which materializes the cells (build_ram_cells<n>) only when expanded
+  PlacementGroup *placementGroup1 =
+    placementGroup->addPlacementGroup(PlacementGroup::Placement::HORIZONTAL, 1, 1, 0, 2);
+
+  placementGroup1->setExpandName(QString("build_ram_cells%1").arg(n));
+
+  auto *gate = new RamArrayGate("RAM", n, n);
+
+  gate->setSchem(this);
+
+  addGate(gate);
+
+  for (int r = 0; r < n; ++r)
+    gate->connectInput(r, hout[r]);
+
+  for (int c = 0; c < n; ++c)
+    gate->connectInput(n + c, vout[c]);
+
+  for (int i = 0; i < 8; ++i) {
+    gate->connectInput (2*n + i, bus[i]);
+    gate->connectOutput(i, bus[i]);
   }
+
+  gate->connectInput(2*n + 8, s);
+  gate->connectInput(2*n + 9, e);
+
+  placementGroup1->addGate(gate);
 }
 
 void
@@ -5284,39 +5961,44 @@ addConnection(const QString &name)
 {
   Connection *connection = new Connection(name);
 
+  simValid_ = false;
+
   connection->setSchem(this);
+  connection->setSchemInd(int(connections_.size()));
 
   connections_.push_back(connection);
 
   return connection;
 }
 
+// remove functions just clear the object's slot so order is kept (exec order matters)
+// and removal is O(1). compactObjs() must be called when done removing.
 void
 Schematic::
 removeConnection(Connection *connection)
 {
-  uint i = 0;
-  auto n = connections_.size();
+  auto i = uint(connection->schemInd());
 
-  for ( ; i < n; ++i) {
-    if (connections_[i] == connection)
-      break;
-  }
+  assert(i < connections_.size() && connections_[i] == connection);
 
-  assert(i < n);
+  connections_[i] = nullptr;
 
-  delete connections_[i++];
+  ++numRemoved_;
 
-  for ( ; i < n; ++i)
-    connections_[i - 1] = connections_[i];
+  // free routed channels (connection memory may be reused by a new connection)
+  connection->releaseChannels(routeChannels_);
 
-  connections_.pop_back();
+  delete connection;
 }
 
 void
 Schematic::
 addGate(Gate *gate)
 {
+  simValid_ = false;
+
+  gate->setSchemInd(int(gates_.size()));
+
   gates_.push_back(gate);
 
   placementGroup_->addGate(gate);
@@ -5326,22 +6008,17 @@ void
 Schematic::
 removeGate(Gate *gate)
 {
-  uint i = 0;
-  auto n = gates_.size();
+  simValid_ = false;
 
-  for ( ; i < n; ++i) {
-    if (gates_[i] == gate)
-      break;
-  }
+  auto i = uint(gate->schemInd());
 
-  assert(i < n);
+  assert(i < gates_.size() && gates_[i] == gate);
 
-  delete gates_[i++];
+  gates_[i] = nullptr;
 
-  for ( ; i < n; ++i)
-    gates_[i - 1] = gates_[i];
+  ++numRemoved_;
 
-  gates_.pop_back();
+  delete gate;
 }
 
 Bus *
@@ -5350,6 +6027,8 @@ addBus(const QString &name, int n)
 {
   Bus *bus = new Bus(name, n);
 
+  bus->setSchemInd(int(buses_.size()));
+
   buses_.push_back(bus);
 
   return bus;
@@ -5359,22 +6038,59 @@ void
 Schematic::
 removeBus(Bus *bus)
 {
-  uint i = 0;
-  auto n = buses_.size();
+  auto i = uint(bus->schemInd());
 
-  for ( ; i < n; ++i) {
-    if (buses_[i] == bus)
-      break;
-  }
+  assert(i < buses_.size() && buses_[i] == bus);
 
-  assert(i < n);
+  buses_[i] = nullptr;
 
-  delete buses_[i++];
+  ++numRemoved_;
 
-  for ( ; i < n; ++i)
-    buses_[i - 1] = buses_[i];
+  delete bus;
+}
 
-  buses_.pop_back();
+void
+Schematic::
+compactObjs()
+{
+  if (numRemoved_ == 0)
+    return;
+
+  // remove cleared slots keeping order and update stored indices
+  auto compact = [](auto &objs) {
+    uint j = 0;
+
+    for (auto &obj : objs) {
+      if (! obj)
+        continue;
+
+      obj->setSchemInd(int(j));
+
+      objs[j++] = obj;
+    }
+
+    objs.resize(j);
+  };
+
+  // keep toggle counts with their connections
+  if (! toggles_.empty()) {
+    toggles_.resize(connections_.size());
+
+    uint j = 0;
+
+    for (uint i = 0; i < connections_.size(); ++i) {
+      if (connections_[i])
+        toggles_[j++] = toggles_[i];
+    }
+
+    toggles_.resize(j);
+  }
+
+  compact(gates_);
+  compact(connections_);
+  compact(buses_);
+
+  numRemoved_ = 0;
 }
 
 PlacementGroup *
@@ -5395,970 +6111,5043 @@ addPlacementGroup(PlacementGroup *placementGroup)
   placementGroup_->addPlacementGroup(placementGroup);
 }
 
-bool
-Schematic::
-exec()
+// class name of gate for stats (namespace removed)
+static const QString &
+gateClassName(const std::type_info &typeInfo)
 {
-  bool changed = false;
+  static std::unordered_map<std::type_index, QString> names;
 
-  for (auto &gate : gates_) {
-    if (gate->exec())
-      changed = true;
-  }
+  std::type_index type(typeInfo);
 
-  ++t_;
+  auto p = names.find(type);
 
-  redraw();
+  if (p == names.end()) {
+    const char *name = type.name();
 
-  return changed;
+#ifdef __GNUG__
+    int status = 0;
+
+    char *dname = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+
+    QString str = (status == 0 && dname ? QString(dname) : QString(name));
+
+    free(dname);
+#else
+    QString str(name);
+#endif
+
+    int pos = str.lastIndexOf("::");
+
+    if (pos >= 0)
+      str = str.mid(pos + 2);
+
+    p = names.insert(p, std::make_pair(type, str));
+  }
+
+  return (*p).second;
+}
+
+static const QString &
+gateClassName(const Gate *gate)
+{
+  return gateClassName(typeid(*gate));
 }
 
 void
 Schematic::
-test()
+initStats()
 {
-  std::vector<Connection *> in, out;
+  if (! gateStats_.empty())
+    return;
 
-  for (const auto &connection : connections_) {
-    if      (connection->isInput())
-      in.push_back(connection);
-    else if (connection->isOutput())
-      out.push_back(connection);
-  }
+  gateStats_.resize(uint(StatSlot::NUM_FIXED));
 
-  auto ni = in .size();
-  auto no = out.size();
+  gateStats_[uint(StatSlot::SIM_AIG )].name = "SimAig";
+  gateStats_[uint(StatSlot::NAND_NOT)].name = "NandGate+NotGate";
+  gateStats_[uint(StatSlot::NOT_NOT )].name = "NotGate+NotGate";
+}
 
-  uint n = uint(std::pow(2, ni));
+Schematic::GateStat &
+Schematic::
+gateStat(const Gate *gate)
+{
+  const std::type_info &type = typeid(*gate);
 
-  for (uint j = 0; j < ni; ++j)
-    std::cerr << in[uint(ni - j - 1)]->name().toStdString();
+  uint i = uint(gate->schemInd());
 
-  std::cerr << " = ";
+  if (i >= gateStatInds_.size())
+    gateStatInds_.resize(std::max(gates_.size(), size_t(i) + 1), -1);
 
-  for (uint j = 0; j < no; ++j)
-    std::cerr << out[uint(no - j - 1)]->name().toStdString();
+  // cached slot still valid if gate (at this index) has same class
+  int ind = gateStatInds_[i];
 
-  std::cerr << "\n";
+  if (ind >= 0 && *gateStats_[uint(ind)].type == type)
+    return gateStats_[uint(ind)];
 
-  for (uint i = 0; i < n; ++i) {
-    for (uint j = 0; j < ni; ++j)
-      in[uint(j)]->setValue(i & (1 << j));
+  // find or add class slot (few classes so linear search)
+  ind = -1;
 
-    exec();
+  for (uint j = uint(StatSlot::NUM_FIXED); j < gateStats_.size(); ++j) {
+    if (*gateStats_[j].type == type) {
+      ind = int(j);
+      break;
+    }
+  }
 
-    //---
+  if (ind < 0) {
+    ind = int(gateStats_.size());
 
-    for (uint j = 0; j < ni; ++j)
-      std::cerr << (in[uint(ni - j - 1)]->getValue() ? "1" : "0");
+    gateStats_.emplace_back();
 
-    std::cerr << " = ";
+    gateStats_.back().type = &type;
+  }
 
-    for (uint j = 0; j < no; ++j)
-      std::cerr << (out[uint(no - j - 1)]->getValue() ? "1" : "0");
+  gateStatInds_[i] = ind;
 
-    std::cerr << "\n";
-  }
+  return gateStats_[uint(ind)];
 }
 
-void
+bool
 Schematic::
-addTValue(const Connection *connection, bool b)
+exec()
 {
-  if (waveform_) {
-    waveform_->addValue(connection, t_, b);
+  Trace::Scope trace("sim", "Schematic::exec");
 
-    waveform_->update();
-  }
-}
+  using Clock = std::chrono::steady_clock;
 
-void
-Schematic::
-place()
-{
-  placementGroup_->place();
+  // add time from t1 to t2 to stat
+  auto addStat = [&](GateStat &stat, const Clock::time_point &t1,
+                     const Clock::time_point &t2, bool changed) {
+    ++stat.calls;
 
-  calcBounds();
-}
+    if (changed)
+      ++stat.changed;
 
-void
-Schematic::
-calcBounds()
-{
-  rect_ = QRectF();
+    stat.time += std::chrono::duration<double, std::milli>(t2 - t1).count();
+  };
 
-  for (auto &gate : gates_) {
-    QRectF rect = gate->rect();
+  // evaluations actually executed (gates, fused ops and AIG ands)
+  long evals = 0;
 
-    if (! rect_.isValid())
-      rect_ = rect;
-    else
-      rect_ = rect_.united(rect);
-  }
+  auto gateExec = [&](Gate *gate) {
+    ++evals;
 
-  //---
+    if (! stats_)
+      return gate->exec();
 
-  double a = (height() > 0 ? 1.0*width()/height() : 1.0);
+    // slot lookup outside timed interval
+    GateStat &stat = gateStat(gate);
 
-  double w = rect_.width ();
-  double h = rect_.height();
+    auto t1 = Clock::now();
 
-  if (a > 1.0)
-    h *= a;
-  else
-    w *= a;
+    bool changed = gate->exec();
 
-  double m = renderer_.pixelWidthToWindowWidth(100);
+    auto t2 = Clock::now();
 
-  QPointF c = rect_.center();
+    addStat(stat, t1, t2, changed);
 
-  rect_ = QRectF(c.x() - w/2 - m, c.y() - h/2 - m, w + 2*m, h + 2*m);
+    return changed;
+  };
+
+  auto fixedStat = [&](StatSlot slot) -> GateStat & { return gateStats_[uint(slot)]; };
+
+  if (stats_)
+    initStats();
 
   //---
 
-  renderer_.displayRange.setWindowRange(rect_.left(), rect_.top(), rect_.right(), rect_.bottom());
-}
+  // counters are enabled per batch (see startPerfBatch) so only single ticks start here
+  bool perfTick = (perf_ && ! perfBatch_);
 
-void
-Schematic::
-resizeEvent(QResizeEvent *)
-{
-  renderer_.displayRange.setEqualScale(true);
+  if (perfTick)
+    perfCounters_.start();
 
-  renderer_.displayRange.setPixelRange(0, 0, this->width() - 1, this->height() - 1);
+  bool changed = false;
 
-  image_   = QImage(size(), QImage::Format_ARGB32);
-  changed_ = true;
+  if (optimize_ || aig_) {
+    if (! simValid_)
+      compileSim();
 
-  calcBounds();
-}
+    if (aig_) {
+      auto t1 = (stats_ ? Clock::now() : Clock::time_point());
 
-void
-Schematic::
-paintEvent(QPaintEvent *)
-{
-  QPainter painter(this);
+      bool aigChanged = simAig_.exec();
 
-  painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+      if (stats_)
+        addStat(fixedStat(StatSlot::SIM_AIG), t1, Clock::now(), aigChanged);
 
-  if (changed_) {
-    // draw new data
-    QPainter ipainter(&image_);
+      evals += simAig_.numAnds();
 
-    ipainter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+      if (aigChanged)
+        changed = true;
+    }
 
-    ipainter.fillRect(rect(), QBrush(Qt::black));
+    auto setOutput = [](Gate *gate, bool b) {
+      Port *port = gate->outputs()[0];
 
-    renderer_.schem         = this;
-    renderer_.painter       = &ipainter;
-    renderer_.prect         = rect();
-    renderer_.rect          = rect_;
-    renderer_.placementRect = placementGroup_->rect();
-    renderer_.selected      = false;
-    renderer_.inside        = false;
+      if (b == port->getValue())
+        return false;
 
-    for (const auto &gate : gates_)
-      gate->draw(&renderer_);
+      port->setValue(b);
 
-    for (const auto &connection : connections_) {
-      if (! connection->bus())
-        connection->draw(&renderer_);
-    }
+      return true;
+    };
 
-    for (const auto &bus : buses_)
-      bus->draw(&renderer_);
+    for (const auto &op : simOps_) {
+      switch (op.type) {
+        case SimOp::Type::GATE: {
+          if (gateExec(op.gate1))
+            changed = true;
 
-    placementGroup_->draw(&renderer_);
+          break;
+        }
+        case SimOp::Type::NAND_NOT: {
+          ++evals;
 
-    changed_ = false;
-  }
+          auto t1 = (stats_ ? Clock::now() : Clock::time_point());
 
-  //---
+          bool b = (op.gate1->inputs()[0]->getValue() && op.gate1->inputs()[1]->getValue());
 
-  // draw cached data
-  painter.drawImage(0, 0, image_);
+          bool opChanged1 = setOutput(op.gate1, ! b);
+          bool opChanged2 = setOutput(op.gate2,   b);
 
-  //---
+          if (stats_)
+            addStat(fixedStat(StatSlot::NAND_NOT), t1, Clock::now(), opChanged1 || opChanged2);
 
-  // draw selected and inside
-  renderer_.schem         = this;
-  renderer_.painter       = &painter;
-  renderer_.prect         = rect();
-  renderer_.rect          = rect_;
-  renderer_.placementRect = placementGroup_->rect();
+          if (opChanged1 || opChanged2)
+            changed = true;
 
-  Gates selGates;
+          break;
+        }
+        case SimOp::Type::NOT_NOT: {
+          ++evals;
 
-  selectedGates(selGates);
+          auto t1 = (stats_ ? Clock::now() : Clock::time_point());
 
-  for (const auto &gate : selGates) {
-    renderer_.selected = true;
-    renderer_.inside   = false;
+          bool b = op.gate1->inputs()[0]->getValue();
 
-    gate->draw(&renderer_);
-  }
+          bool opChanged1 = setOutput(op.gate1, ! b);
+          bool opChanged2 = setOutput(op.gate2,   b);
 
-  if (insideGate()) {
-    renderer_.selected = false;
-    renderer_.inside   = true;
+          if (stats_)
+            addStat(fixedStat(StatSlot::NOT_NOT), t1, Clock::now(), opChanged1 || opChanged2);
 
-    insideGate()->draw(&renderer_);
-  }
+          if (opChanged1 || opChanged2)
+            changed = true;
 
-  Connections selConnections;
+          break;
+        }
+      }
+    }
+  }
+  else {
+    for (auto &gate : gates_) {
+      if (gateExec(gate))
+        changed = true;
+    }
+  }
 
-  selectedConnections(selConnections);
+  if (perfTick)
+    perfCounters_.stop();
 
-  for (const auto &connection : selConnections) {
-    renderer_.selected = true;
-    renderer_.inside   = false;
+  if (perf_) {
+    ++perfTicks_;
 
-    connection->draw(&renderer_);
+    perfEvals_ += evals;
   }
 
-  if (insideConnection()) {
-    renderer_.selected = false;
-    renderer_.inside   = true;
+  if (stats_) {
+    ++statsTicks_;
 
-    insideConnection()->draw(&renderer_);
+    if (statsPanel_)
+      statsPanel_->update();
   }
 
-#if 0
-  Buses selBuses;
+  ++t_;
 
-  selectedBuses(selBuses);
+  redrawValues();
 
-  for (const auto &bus : selBuses) {
-    renderer_.selected = true;
-    renderer_.inside   = false;
+  return changed;
+}
 
-    bus->draw(&renderer_);
+std::vector<QString>
+Schematic::
+statsLines() const
+{
+  using NameStat  = std::pair<QString, GateStat>;
+  using NameStats = std::vector<NameStat>;
+
+  // names of used slots
+  NameStats nameStats;
+
+  for (const auto &stat : gateStats_) {
+    if (stat.calls == 0)
+      continue;
+
+    nameStats.push_back(NameStat(stat.name ? QString(stat.name) : gateClassName(*stat.type), stat));
   }
-#endif
 
-  PlacementGroups selPlacementGroups;
+  std::sort(nameStats.begin(), nameStats.end(), [](const NameStat &lhs, const NameStat &rhs) {
+    return (lhs.second.time > rhs.second.time);
+  });
 
-  selectedPlacementGroups(selPlacementGroups);
+  double totalTime = 0.0;
 
-  for (const auto &placementGroup : selPlacementGroups) {
-    renderer_.selected = true;
-    renderer_.inside   = false;
+  for (const auto &nameStat : nameStats)
+    totalTime += nameStat.second.time;
 
-    placementGroup->draw(&renderer_);
-  }
+  //---
 
-  if (insidePlacement()) {
-    renderer_.selected = false;
-    renderer_.inside   = true;
+  std::vector<QString> lines;
 
-    insidePlacement()->draw(&renderer_);
+  lines.push_back(QString("%1 ticks, %2ms").arg(statsTicks_).arg(totalTime, 0, 'f', 3));
+
+  lines.push_back(QString("%1 %2 %3 %4 %5 %6 %7").
+    arg("Type", -20).arg("Calls", 12).arg("Changed", 12).arg("Changed%", 9).
+    arg("Time(ms)", 12).arg("ns/Call", 9).arg("Time%", 7));
+
+  for (const auto &nameStat : nameStats) {
+    const GateStat &stat = nameStat.second;
+
+    double changedPercent = (stat.calls > 0 ? 100.0*double(stat.changed)/double(stat.calls) : 0.0);
+    double nsPerCall      = (stat.calls > 0 ? 1E6*stat.time/double(stat.calls) : 0.0);
+    double timePercent    = (totalTime > 0.0 ? 100.0*stat.time/totalTime : 0.0);
+
+    lines.push_back(QString("%1 %2 %3 %4 %5 %6 %7").
+      arg(nameStat.first, -20).arg(stat.calls, 12).arg(stat.changed, 12).
+      arg(changedPercent, 9, 'f', 1).arg(stat.time, 12, 'f', 3).
+      arg(nsPerCall, 9, 'f', 1).arg(timePercent, 7, 'f', 1));
   }
+
+  return lines;
 }
 
 void
 Schematic::
-mousePressEvent(QMouseEvent *e)
+printStats() const
 {
-  pressed_    = false;
-  pressPoint_ = QPointF(e->x(), e->y());
+  for (const auto &line : statsLines())
+    std::cerr << line.toStdString() << "\n";
+}
 
-  if      (e->button() == Qt::LeftButton) {
-    pressGate_      = nullptr;
-    pressPlacement_ = nullptr;
+// gate output only depends on current inputs
+static bool
+isCombinationalGate(const Gate *gate)
+{
+  return (dynamic_cast<const NandGate        *>(gate) || dynamic_cast<const NotGate      *>(gate) ||
+          dynamic_cast<const AndGate         *>(gate) || dynamic_cast<const And3Gate     *>(gate) ||
+          dynamic_cast<const And4Gate        *>(gate) || dynamic_cast<const And8Gate     *>(gate) ||
+          dynamic_cast<const OrGate          *>(gate) || dynamic_cast<const Or8Gate      *>(gate) ||
+          dynamic_cast<const XorGate         *>(gate) || dynamic_cast<const EnablerGate  *>(gate) ||
+          dynamic_cast<const Decoder4Gate    *>(gate) || dynamic_cast<const Decoder8Gate *>(gate) ||
+          dynamic_cast<const Decoder16Gate   *>(gate) || dynamic_cast<const Decoder256Gate *>(gate) ||
+          dynamic_cast<const InverterGate    *>(gate) || dynamic_cast<const AnderGate    *>(gate) ||
+          dynamic_cast<const OrerGate        *>(gate) || dynamic_cast<const XorerGate    *>(gate) ||
+          dynamic_cast<const AdderGate       *>(gate) || dynamic_cast<const Adder8Gate   *>(gate) ||
+          dynamic_cast<const ComparatorGate  *>(gate) ||
+          dynamic_cast<const Comparator8Gate *>(gate) || dynamic_cast<const Bus0Gate     *>(gate) ||
+          dynamic_cast<const Bus1Gate        *>(gate) || dynamic_cast<const AluGate      *>(gate));
+}
 
-    if      (moveGate_) {
-      pressGate_ = nearestGate(pressPoint_);
+void
+Schematic::
+compileSim()
+{
+  Trace::Scope trace("sim", "Schematic::compileSim");
 
-      if (pressGate_) {
-        deselectAll();
+  // build list of ops equivalent to exec of all gates in order (optimize):
+  //  . constant gates (combinational with only unconnected inputs or inputs driven only by
+  //    constant gates) are evaluated once here
+  //  . dead gates (combinational with no connected outputs) are skipped
+  //  . NAND->NOT and NOT->NOT pairs are fused into single op at the position of the second
+  //    gate if the intermediate net has no other driver or reader and no gate between them
+  //    drives the first gate's inputs
+  // nets without readers are circuit outputs (see test()) so are still driven
+  compactObjs();
 
-        pressGate_->setSelected(! pressGate_->isSelected());
+  simOps_.clear();
 
-        update();
-      }
-    }
-    else if (movePlacement_) {
-      pressPlacement_ = nearestPlacementGroup(pressPoint_);
+  auto ng = gates_.size();
 
-      if (pressPlacement_) {
-        deselectAll();
+  auto gateInd = [](const Port *port) { return uint(port->gate()->schemInd()); };
 
-        pressPlacement_->setSelected(! pressPlacement_->isSelected());
+  //---
 
-        update();
-      }
-    }
-    else if (moveConnection_) {
-      pressConnection_ = nearestConnection(pressPoint_);
+  // gates lowered to and-inverter graph (evaluated before ops)
+  auto aigGates = std::vector<uchar>(ng, 0);
 
-      if (pressConnection_) {
-        deselectAll();
+  simAig_.clear();
 
-        pressConnection_->setSelected(! pressConnection_->isSelected());
+  if (aig_)
+    compileAig(aigGates);
 
-        update();
-      }
-    }
+  //---
 
-    pressed_ = true;
-  }
-  else if (e->button() == Qt::MiddleButton) {
-    pressConnection_ = nearestConnection(pressPoint_);
+  auto constGates = std::vector<uchar>(ng, 0);
 
-    if (pressConnection_) {
-      if (pressConnection_->isInput()) {
-        pressConnection_->setValue(! pressConnection_->getValue());
+  bool changed = optimize_;
 
-        exec();
+  while (changed) {
+    changed = false;
+
+    for (uint i = 0; i < ng; ++i) {
+      Gate *gate = gates_[i];
+
+      if (constGates[i] || aigGates[i] || ! isCombinationalGate(gate))
+        continue;
+
+      bool isConst = true;
+
+      for (const auto &port : gate->inputs()) {
+        Connection *connection = port->connection();
+        if (! connection) continue;
+
+        // undriven nets are inputs (set by user)
+        if (connection->inPorts().empty())
+          isConst = false;
+
+        for (const auto &iport : connection->inPorts()) {
+          if (! constGates[gateInd(iport)])
+            isConst = false;
+        }
+
+        if (! isConst)
+          break;
+      }
 
-        redraw();
+      if (isConst) {
+        constGates[i] = 1;
+
+        changed = true;
       }
     }
   }
-  else if (e->button() == Qt::RightButton) {
-    QMenu *menu = new QMenu(this);
 
-    auto addAction = [&](QMenu *menu, const QString &name, const char *slotName) {
-      QAction *action = new QAction(name, menu);
+  // evaluate constant gates until stable
+  for (uint n = 0; n <= ng; ++n) {
+    changed = false;
 
-      connect(action, SIGNAL(triggered()), this, slotName);
+    for (uint i = 0; i < ng; ++i) {
+      if (constGates[i] && gates_[i]->exec())
+        changed = true;
+    }
 
-      menu->addAction(action);
+    if (! changed)
+      break;
+  }
 
-      return action;
-    };
+  //---
 
-    addAction(menu, "Expand"  , SLOT(expandSlot  ()));
-    addAction(menu, "Collapse", SLOT(collapseSlot()));
+  auto deadGates = std::vector<uchar>(ng, 0);
 
-    menu->addSeparator();
+  for (uint i = 0; i < ng; ++i) {
+    Gate *gate = gates_[i];
 
-    addAction(menu, "Place", SLOT(placeSlot()));
+    if (! optimize_ || constGates[i] || aigGates[i] || ! isCombinationalGate(gate))
+      continue;
 
-    menu->exec(mapToGlobal(e->pos()));
+    bool isDead = true;
+
+    for (const auto &port : gate->outputs()) {
+      if (port->connection())
+        isDead = false;
+    }
+
+    if (isDead)
+      deadGates[i] = 1;
   }
-}
 
-void
-Schematic::
-mouseMoveEvent(QMouseEvent *e)
-{
-  movePoint_ = QPointF(e->x(), e->y());
+  //---
 
-  window_->setPos(renderer_.pixelToWindow(movePoint_));
+  // index of second gate of fused pair for first gate (0 if not fused)
+  auto fuseGates = std::vector<uint>(ng, 0);
+  auto fusedOps  = std::vector<SimOp::Type>(ng, SimOp::Type::GATE);
 
-  double dx = std::abs(pressPoint_.x() - movePoint_.x());
-  double dy = std::abs(pressPoint_.y() - movePoint_.y());
+  for (uint i = 0; i < ng; ++i) {
+    Gate *gate1 = gates_[i];
 
-  if (dx < 1 && dy < 1)
-    return;
+    // skip gates already second of pair
+    if (! optimize_ || constGates[i] || deadGates[i] || aigGates[i] ||
+        fusedOps[i] != SimOp::Type::GATE)
+      continue;
 
-  if (! pressed_) {
-    if      (moveGate_) {
-      Gate *gate = nearestGate(movePoint_);
+    SimOp::Type type;
 
-      if (gate != insideGate_) {
-        insideGate_ = gate;
+    if      (dynamic_cast<NandGate *>(gate1))
+      type = SimOp::Type::NAND_NOT;
+    else if (dynamic_cast<NotGate *>(gate1))
+      type = SimOp::Type::NOT_NOT;
+    else
+      continue;
 
-        update();
-      }
-    }
-    else if (movePlacement_) {
-      PlacementGroup *placement = nearestPlacementGroup(movePoint_);
+    Connection *connection = gate1->outputs()[0]->connection();
 
-      if (placement != insidePlacement_) {
-        insidePlacement_ = placement;
+    if (! connection || connection->isTraced() ||
+        connection->inPorts().size() != 1 || connection->outPorts().size() != 1)
+      continue;
 
-        update();
-      }
-    }
-    else if (moveConnection_) {
-      Connection *connection = nearestConnection(movePoint_);
+    uint j = gateInd(connection->outPorts()[0]);
 
-      if (connection != insideConnection_) {
-        insideConnection_ = connection;
+    if (j <= i || constGates[j] || deadGates[j] || aigGates[j] ||
+        fusedOps[j] != SimOp::Type::GATE || ! dynamic_cast<NotGate *>(gates_[j]))
+      continue;
 
-        update();
+    bool valid = true;
+
+    for (const auto &port : gate1->inputs()) {
+      Connection *connection1 = port->connection();
+      if (! connection1) continue;
+
+      for (const auto &iport : connection1->inPorts()) {
+        uint k = gateInd(iport);
+
+        if (k > i && k < j)
+          valid = false;
       }
     }
 
-    return;
+    if (! valid)
+      continue;
+
+    fuseGates[i] = j;
+    fusedOps [j] = type;
   }
 
-  if      (pressGate_) {
-    QPointF p1 = renderer_.pixelToWindow(QPointF(pressPoint_.x(), pressPoint_.y()));
-    QPointF p2 = renderer_.pixelToWindow(QPointF(movePoint_ .x(), movePoint_ .y()));
+  //---
 
-    pressGate_->setRect(pressGate_->rect().translated(p2.x() - p1.x(), p2.y() - p1.y()));
+  int nf = 0;
 
-    calcBounds();
+  for (uint i = 0; i < ng; ++i) {
+    if (constGates[i] || deadGates[i] || fuseGates[i] || aigGates[i])
+      continue;
 
-    redraw();
+    if (fusedOps[i] != SimOp::Type::GATE) {
+      Gate *gate2 = gates_[i];
+      Gate *gate1 = gates_[gateInd(gate2->inputs()[0]->connection()->inPorts()[0])];
+
+      simOps_.push_back(SimOp(fusedOps[i], gate1, gate2));
+
+      ++nf;
+    }
+    else
+      simOps_.push_back(SimOp(SimOp::Type::GATE, gates_[i]));
   }
-  else if (pressPlacement_) {
-    QPointF p1 = renderer_.pixelToWindow(QPointF(pressPoint_.x(), pressPoint_.y()));
-    QPointF p2 = renderer_.pixelToWindow(QPointF(movePoint_ .x(), movePoint_ .y()));
 
-    pressPlacement_->setRect(pressPlacement_->rect().translated(p2.x() - p1.x(), p2.y() - p1.y()));
+  simValid_ = true;
 
-    calcBounds();
-
-    redraw();
-  }
-
-  pressPoint_ = movePoint_;
+  if (getenv("CQSCHEM_DEBUG_SIM"))
+    std::cerr << "Sim " << ng << " gates -> " << simOps_.size() << " ops (" <<
+                 std::count(constGates.begin(), constGates.end(), 1) << " constant, " <<
+                 std::count(deadGates.begin(), deadGates.end(), 1) << " dead, " <<
+                 nf << " fused, " << std::count(aigGates.begin(), aigGates.end(), 1) <<
+                 " lowered to " << simAig_.numAnds() << " and nodes with " <<
+                 simAig_.numInputs() << " inputs, " << simAig_.numMerged() << " merged)\n";
 }
 
-void
-Schematic::
-mouseReleaseEvent(QMouseEvent *e)
+// lowered gate output only depends on current inputs and maps directly to and nodes
+static bool
+isAigGate(const Gate *gate)
 {
-  mouseMoveEvent(e);
-
-  pressed_ = false;
+  return (dynamic_cast<const NandGate *>(gate) || dynamic_cast<const NotGate *>(gate) ||
+          dynamic_cast<const AndGate  *>(gate) || dynamic_cast<const And3Gate *>(gate) ||
+          dynamic_cast<const And4Gate *>(gate) || dynamic_cast<const And8Gate *>(gate) ||
+          dynamic_cast<const OrGate   *>(gate) || dynamic_cast<const Or8Gate  *>(gate) ||
+          dynamic_cast<const XorGate  *>(gate));
 }
 
 void
 Schematic::
-keyPressEvent(QKeyEvent *e)
+compileAig(std::vector<uchar> &aigGates)
 {
-  if      (e->key() == Qt::Key_Plus)
-    renderer_.displayTransform.zoomIn();
-  else if (e->key() == Qt::Key_Minus)
-    renderer_.displayTransform.zoomOut();
-  else if (e->key() == Qt::Key_Left)
-    renderer_.displayTransform.panLeft();
-  else if (e->key() == Qt::Key_Right)
-    renderer_.displayTransform.panRight();
-  else if (e->key() == Qt::Key_Up)
-    renderer_.displayTransform.panUp();
-  else if (e->key() == Qt::Key_Down)
-    renderer_.displayTransform.panDown();
-  else if (e->key() == Qt::Key_Home)
-    renderer_.displayTransform.reset();
-  else if (e->key() == Qt::Key_Greater) {
-    Gates gates;
+  // lower single output combinational gates to and-inverter graph. Gates in combinational
+  // loops (latches) or driving nets with other drivers are kept as gates.
+  // Lowered logic is evaluated in dependency order at the start of each exec so it settles
+  // in one exec instead of following gate order
+  auto ng = gates_.size();
 
-    selectedGates(gates);
+  auto gateInd = [](const Port *port) { return uint(port->gate()->schemInd()); };
 
-    for (auto &gate : gates)
-      gate->nextOrient();
-  }
-  else if (e->key() == Qt::Key_Less) {
-    Gates gates;
+  auto candidates = std::vector<uchar>(ng, 0);
 
-    selectedGates(gates);
+  for (uint i = 0; i < ng; ++i) {
+    Gate *gate = gates_[i];
 
-    for (auto &gate : gates)
-      gate->prevOrient();
+    if (! isAigGate(gate))
+      continue;
+
+    Connection *connection = gate->outputs()[0]->connection();
+
+    if (connection && connection->inPorts().size() != 1)
+      continue;
+
+    candidates[i] = 1;
   }
-  else if (e->key() == Qt::Key_F) {
-    Gates gates;
 
-    selectedGates(gates);
+  // candidate successors (readers of output net)
+  auto succStart = std::vector<uint>(ng + 1, 0);
 
-    for (auto &gate : gates)
-      gate->setFlipped(! gate->isFlipped());
+  std::vector<uint> succ;
+
+  for (uint i = 0; i < ng; ++i) {
+    succStart[i] = uint(succ.size());
+
+    if (! candidates[i])
+      continue;
+
+    Connection *connection = gates_[i]->outputs()[0]->connection();
+    if (! connection) continue;
+
+    for (const auto &port : connection->outPorts()) {
+      uint j = gateInd(port);
+
+      if (candidates[j])
+        succ.push_back(j);
+    }
   }
 
-  redraw();
-}
+  succStart[ng] = uint(succ.size());
 
-void
-Schematic::
-deselectAll()
-{
-  Gates selGates;
+  //---
 
-  selectedGates(selGates);
+  // strongly connected components (iterative Tarjan). Components are found in reverse
+  // topological order and any gate in a cycle is not lowered
+  const uint noIndex = uint(-1);
 
-  for (auto &gate : selGates)
-    gate->setSelected(false);
+  auto index   = std::vector<uint>(ng, noIndex);
+  auto low     = std::vector<uint>(ng, 0);
+  auto onStack = std::vector<uchar>(ng, 0);
 
-  Connections selConnections;
+  std::vector<uint> stack, order;
 
-  selectedConnections(selConnections);
+  struct Frame {
+    uint gate { 0 };
+    uint succ { 0 };
+  };
 
-  for (auto &connection : selConnections)
-    connection->setSelected(false);
+  std::vector<Frame> frames;
 
-  PlacementGroups selPlacementGroups;
+  uint nextIndex = 0;
 
-  selectedPlacementGroups(selPlacementGroups);
+  for (uint i = 0; i < ng; ++i) {
+    if (! candidates[i] || index[i] != noIndex)
+      continue;
 
-  for (auto &placementGroup : selPlacementGroups)
-    placementGroup->setSelected(false);
-}
+    frames.push_back(Frame{i, succStart[i]});
 
-void
-Schematic::
-expandSlot()
-{
-  resetObjs();
+    index[i] = low[i] = nextIndex++;
 
-  PlacementGroups expandGroups;
+    stack.push_back(i); onStack[i] = 1;
 
-  PlacementGroups selPlacementGroups;
+    while (! frames.empty()) {
+      Frame &frame = frames.back();
 
-  selectedPlacementGroups(selPlacementGroups);
+      uint v = frame.gate;
 
-  if (! selPlacementGroups.empty()) {
-    for (auto &placementGroup : selPlacementGroups) {
-      if (placementGroup->expandName() != "")
-        expandGroups.push_back(placementGroup);
-    }
-  }
-  else {
-    Gates selGates;
+      if (frame.succ < succStart[v + 1]) {
+        uint w = succ[frame.succ++];
 
-    selectedGates(selGates);
+        if      (index[w] == noIndex) {
+          index[w] = low[w] = nextIndex++;
 
-    if (! selGates.empty()) {
-      for (auto &gate : selGates) {
-        PlacementGroup *placementGroup = gate->placementGroup();
+          stack.push_back(w); onStack[w] = 1;
 
-        if (placementGroup->expandName() != "")
-          expandGroups.push_back(placementGroup);
-      }
-    }
-    else {
-      for (auto &placementGroupData : placementGroup_->placementGroups()) {
-        PlacementGroup *placementGroup = placementGroupData.placementGroup;
+          frames.push_back(Frame{w, succStart[w]});
+        }
+        else if (onStack[w])
+          low[v] = std::min(low[v], index[w]);
 
-        if (placementGroup->expandName() != "")
-          expandGroups.push_back(placementGroup);
+        continue;
       }
-    }
-  }
 
-  //---
+      frames.pop_back();
 
-  PlacementGroups newPlacementGroups;
+      if (! frames.empty())
+        low[frames.back().gate] = std::min(low[frames.back().gate], low[v]);
 
-  for (auto &placementGroup : expandGroups) {
-    PlacementGroup *parentGroup = placementGroup->parent();
+      if (low[v] != index[v])
+        continue;
 
-    bool rc = execGate(parentGroup, placementGroup->expandName());
-    assert(rc);
+      // pop component (single gate without self loop is acyclic)
+      bool cyclic = (stack.back() != v);
 
-    PlacementGroup *newPlacementGroup =
-      parentGroup->replacePlacementGroup(this, placementGroup);
+      for (uint k = succStart[v]; k < succStart[v + 1]; ++k) {
+        if (succ[k] == v)
+          cyclic = true;
+      }
 
-    newPlacementGroups.push_back(newPlacementGroup);
+      uint w;
+
+      do {
+        w = stack.back(); stack.pop_back(); onStack[w] = 0;
+
+        if (! cyclic)
+          order.push_back(w);
+      } while (w != v);
+    }
   }
 
   //---
 
-  for (auto &placementGroup : newPlacementGroups)
-    placementGroup->place();
+  // build nodes in topological order
+  const uint32_t noLit = uint32_t(-1);
 
-  calcBounds();
+  auto gateLits = std::vector<uint32_t>(ng, noLit);
+  auto netLits  = std::vector<uint32_t>(connections_.size(), noLit);
 
-  redraw();
-}
+  auto inputLit = [&](const Port *port) {
+    Connection *connection = port->connection();
 
-void
-Schematic::
-collapseSlot()
-{
-  resetObjs();
+    // unconnected input is constant false
+    if (! connection)
+      return SimAig::constLit(false);
 
-  PlacementGroups selPlacementGroups;
+    if (connection->inPorts().size() == 1) {
+      uint j = gateInd(connection->inPorts()[0]);
 
-  selectedPlacementGroups(selPlacementGroups);
+      if (gateLits[j] != noLit)
+        return gateLits[j];
+    }
 
-  PlacementGroups collapseGroups;
+    uint32_t &l = netLits[uint(connection->schemInd())];
 
-  if (! selPlacementGroups.empty()) {
-    for (auto &placementGroup : selPlacementGroups) {
-      if (placementGroup->collapseName() != "")
-        collapseGroups.push_back(placementGroup);
-    }
-  }
-  else {
-    Gates selGates;
+    if (l == noLit)
+      l = simAig_.addInput(connection);
 
-    selectedGates(selGates);
+    return l;
+  };
 
-    if (! selGates.empty()) {
-      for (auto &gate : selGates) {
-        PlacementGroup *placementGroup = gate->placementGroup();
+  for (auto i = order.size(); i-- > 0; ) {
+    uint j = order[i];
 
-        if (placementGroup->collapseName() != "")
-          collapseGroups.push_back(placementGroup);
-      }
+    Gate *gate = gates_[j];
+
+    const auto &inputs = gate->inputs();
+
+    uint32_t l;
+
+    if      (dynamic_cast<NotGate *>(gate))
+      l = SimAig::notLit(inputLit(inputs[0]));
+    else if (dynamic_cast<XorGate *>(gate))
+      l = simAig_.addXor(inputLit(inputs[0]), inputLit(inputs[1]));
+    else if (dynamic_cast<OrGate *>(gate) || dynamic_cast<Or8Gate *>(gate)) {
+      l = SimAig::constLit(false);
+
+      for (const auto &port : inputs)
+        l = simAig_.addOr(l, inputLit(port));
     }
     else {
-      for (auto &placementGroupData : placementGroup_->placementGroups()) {
-        PlacementGroup *placementGroup = placementGroupData.placementGroup;
+      l = SimAig::constLit(true);
 
-        if (placementGroup->collapseName() != "")
-          collapseGroups.push_back(placementGroup);
-      }
+      for (const auto &port : inputs)
+        l = simAig_.addAnd(l, inputLit(port));
+
+      if (dynamic_cast<NandGate *>(gate))
+        l = SimAig::notLit(l);
     }
+
+    gateLits[j] = l;
+
+    simAig_.addOutput(gate->outputs()[0], l);
+
+    aigGates[j] = 1;
   }
+}
 
-  //---
+void
+Schematic::
+test()
+{
+  std::vector<Connection *> in, out;
 
-  PlacementGroups newPlacementGroups;
+  for (const auto &connection : connections_) {
+    if      (connection->isInput())
+      in.push_back(connection);
+    else if (connection->isOutput())
+      out.push_back(connection);
+  }
 
-  for (auto &placementGroup : collapseGroups) {
-    PlacementGroup *parentGroup = placementGroup->parent();
+  auto ni = in .size();
+  auto no = out.size();
 
-    bool rc = execGate(parentGroup, placementGroup->collapseName());
-    assert(rc);
+  uint n = uint(std::pow(2, ni));
 
-    PlacementGroup *newPlacementGroup =
-      parentGroup->replacePlacementGroup(this, placementGroup);
+  for (uint j = 0; j < ni; ++j)
+    std::cerr << in[uint(ni - j - 1)]->name().toStdString();
 
-    newPlacementGroups.push_back(newPlacementGroup);
-  }
+  std::cerr << " = ";
 
-  //---
+  for (uint j = 0; j < no; ++j)
+    std::cerr << out[uint(no - j - 1)]->name().toStdString();
 
-  for (auto &placementGroup : newPlacementGroups)
-    placementGroup->place();
+  std::cerr << "\n";
 
-  calcBounds();
+  for (uint i = 0; i < n; ++i) {
+    for (uint j = 0; j < ni; ++j)
+      in[uint(j)]->setValue(i & (1 << j));
 
-  redraw();
-}
+    exec();
 
-void
-Schematic::
-placeSlot()
-{
-  place();
+    //---
 
-  redraw();
+    for (uint j = 0; j < ni; ++j)
+      std::cerr << (in[uint(ni - j - 1)]->getValue() ? "1" : "0");
+
+    std::cerr << " = ";
+
+    for (uint j = 0; j < no; ++j)
+      std::cerr << (out[uint(no - j - 1)]->getValue() ? "1" : "0");
+
+    std::cerr << "\n";
+  }
 }
 
 void
 Schematic::
-resetObjs()
+addTValue(const Connection *connection, bool b)
 {
-  pressGate_        = nullptr;
-  pressPlacement_   = nullptr;
-  insideGate_       = nullptr;
-  insidePlacement_  = nullptr;
-  insideConnection_ = nullptr;
+  if (waveform_) {
+    waveform_->addValue(connection, t_, b);
+
+    waveform_->update();
+  }
 }
 
 void
 Schematic::
-redraw()
+place()
 {
-  changed_ = true;
+  placementGroup_->place();
 
-  update();
+  calcBounds();
 }
 
 void
 Schematic::
-selectedGates(Gates &gates) const
+calcBounds()
 {
+  rect_ = QRectF();
+
   for (auto &gate : gates_) {
-    if (gate->isSelected())
-      gates.push_back(gate);
+    QRectF rect = gate->rect();
+
+    if (! rect_.isValid())
+      rect_ = rect;
+    else
+      rect_ = rect_.united(rect);
   }
-}
 
-void
-Schematic::
+  //---
+
+  double a = (height() > 0 ? 1.0*width()/height() : 1.0);
+
+  double w = rect_.width ();
+  double h = rect_.height();
+
+  if (a > 1.0)
+    h *= a;
+  else
+    w *= a;
+
+  double m = renderer_.pixelWidthToWindowWidth(100);
+
+  QPointF c = rect_.center();
+
+  rect_ = QRectF(c.x() - w/2 - m, c.y() - h/2 - m, w + 2*m, h + 2*m);
+
+  //---
+
+  renderer_.displayRange.setWindowRange(rect_.left(), rect_.top(), rect_.right(), rect_.bottom());
+}
+
+void
+Schematic::
+resizeEvent(QResizeEvent *)
+{
+  renderer_.displayRange.setEqualScale(true);
+
+  renderer_.displayRange.setPixelRange(0, 0, this->width() - 1, this->height() - 1);
+
+  image_   = QImage(size(), QImage::Format_ARGB32);
+  changed_ = true;
+
+  invalidateConnections();
+
+  calcBounds();
+}
+
+void
+Schematic::
+paintEvent(QPaintEvent *)
+{
+  using Phase = PaintProfile::Phase;
+  using Timer = PaintProfile::Timer;
+
+  Trace::Scope trace("paint", "Schematic::paintEvent");
+
+  paintProfile_.startFrame();
+
+  QPainter painter(this);
+
+  painter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+
+  if (changed_) {
+    // draw new data
+    QPainter ipainter(&image_);
+
+    drawContents(&ipainter);
+
+    changed_   = false;
+    dirtyRect_ = QRectF();
+  }
+  else if (dirtyRect_.isValid()) {
+    // only redraw moved area
+    QPainter ipainter(&image_);
+
+    ipainter.setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+
+    ipainter.setClipRect(dirtyRect_);
+
+    ipainter.fillRect(dirtyRect_, QBrush(Qt::black));
+
+    initRenderer(&ipainter);
+
+    {
+      Timer timer(paintProfile_, Phase::GATES);
+
+      for (const auto &gate : gates_) {
+        if (gate->prect().intersects(dirtyRect_)) {
+          gate->draw(&renderer_);
+
+          paintProfile_.addDrawn(Phase::GATES);
+        }
+        else
+          paintProfile_.addCulled(Phase::GATES);
+      }
+    }
+
+    {
+      Timer timer(paintProfile_, Phase::CONNECTIONS);
+
+      for (const auto &connection : connections_) {
+        if (connection->bus())
+          continue;
+
+        if (connection->linesRect().intersects(dirtyRect_)) {
+          connection->draw(&renderer_);
+
+          paintProfile_.addDrawn(Phase::CONNECTIONS);
+        }
+        else
+          paintProfile_.addCulled(Phase::CONNECTIONS);
+      }
+    }
+
+    {
+      Timer timer(paintProfile_, Phase::BUSES);
+
+      for (const auto &bus : buses_)
+        bus->draw(&renderer_);
+
+      paintProfile_.addDrawn(Phase::BUSES, int(buses_.size()));
+    }
+
+    {
+      Timer timer(paintProfile_, Phase::PLACEMENT);
+
+      placementGroup_->draw(&renderer_);
+    }
+
+    dirtyRect_ = QRectF();
+  }
+
+  //---
+
+  // draw cached data
+  {
+    Timer timer(paintProfile_, Phase::BLIT);
+
+    painter.drawImage(0, 0, image_);
+  }
+
+  //---
+
+  // draw selected and inside
+  drawOverlay(&painter);
+
+  renderer_.painter = nullptr;
+
+  //---
+
+  if (showPaintProfile_)
+    drawPaintProfile(&painter);
+}
+
+void
+Schematic::
+drawContents(QPainter *painter)
+{
+  using Phase = PaintProfile::Phase;
+  using Timer = PaintProfile::Timer;
+
+  painter->setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing);
+
+  painter->fillRect(rect(), QBrush(Qt::black));
+
+  initRenderer(painter);
+
+  {
+    Timer timer(paintProfile_, Phase::GATES);
+
+    for (const auto &gate : gates_)
+      gate->draw(&renderer_);
+
+    paintProfile_.addDrawn(Phase::GATES, int(gates_.size()));
+  }
+
+  {
+    Timer timer(paintProfile_, Phase::ROUTE);
+
+    applyCachedRoutes();
+
+    if (isConnectionVisible())
+      routeConnections();
+  }
+
+  {
+    Timer timer(paintProfile_, Phase::CONNECTIONS);
+
+    for (const auto &connection : connections_) {
+      if (connection->bus())
+        continue;
+
+      connection->draw(&renderer_);
+
+      paintProfile_.addDrawn(Phase::CONNECTIONS);
+    }
+  }
+
+  {
+    Timer timer(paintProfile_, Phase::BUSES);
+
+    for (const auto &bus : buses_)
+      bus->draw(&renderer_);
+
+    paintProfile_.addDrawn(Phase::BUSES, int(buses_.size()));
+  }
+
+  {
+    Timer timer(paintProfile_, Phase::PLACEMENT);
+
+    placementGroup_->draw(&renderer_);
+  }
+
+  // save pending layout cache once initial layout is routed (before any edits)
+  if (saveLayoutCacheName_ != "")
+    saveLayoutCache(saveLayoutCacheName_);
+}
+
+void
+Schematic::
+drawOverlay(QPainter *painter)
+{
+  using Phase = PaintProfile::Phase;
+
+  PaintProfile::Timer timer(paintProfile_, Phase::OVERLAY);
+
+  initRenderer(painter);
+
+  Gates selGates;
+
+  selectedGates(selGates);
+
+  for (const auto &gate : selGates) {
+    renderer_.selected = true;
+    renderer_.inside   = false;
+
+    gate->draw(&renderer_);
+  }
+
+  if (insideGate()) {
+    renderer_.selected = false;
+    renderer_.inside   = true;
+
+    insideGate()->draw(&renderer_);
+  }
+
+  Connections selConnections;
+
+  selectedConnections(selConnections);
+
+  for (const auto &connection : selConnections) {
+    renderer_.selected = true;
+    renderer_.inside   = false;
+
+    connection->draw(&renderer_);
+  }
+
+  if (insideConnection()) {
+    renderer_.selected = false;
+    renderer_.inside   = true;
+
+    insideConnection()->draw(&renderer_);
+  }
+
+  paintProfile_.addDrawn(Phase::OVERLAY, int(selGates.size() + selConnections.size()) +
+                         (insideGate() ? 1 : 0) + (insideConnection() ? 1 : 0));
+
+#if 0
+  Buses selBuses;
+
+  selectedBuses(selBuses);
+
+  for (const auto &bus : selBuses) {
+    renderer_.selected = true;
+    renderer_.inside   = false;
+
+    bus->draw(&renderer_);
+  }
+#endif
+
+  PlacementGroups selPlacementGroups;
+
+  selectedPlacementGroups(selPlacementGroups);
+
+  for (const auto &placementGroup : selPlacementGroups) {
+    renderer_.selected = true;
+    renderer_.inside   = false;
+
+    placementGroup->draw(&renderer_);
+  }
+
+  if (insidePlacement()) {
+    renderer_.selected = false;
+    renderer_.inside   = true;
+
+    insidePlacement()->draw(&renderer_);
+  }
+}
+
+void
+Schematic::
+drawPaintProfile(QPainter *painter)
+{
+  auto lines = paintProfile_.lines();
+
+  QFontMetrics fm(font());
+
+  int w = 0;
+
+  for (const auto &line : lines)
+    w = std::max(w, fm.horizontalAdvance(line));
+
+  int h = int(lines.size())*fm.height();
+
+  painter->fillRect(QRect(0, 0, w + 8, h + 8), QColor(0, 0, 0, 192));
+
+  painter->setPen(Qt::white);
+
+  int y = 4;
+
+  for (const auto &line : lines) {
+    painter->drawText(4, y + fm.ascent(), line);
+
+    y += fm.height();
+  }
+}
+
+void
+Schematic::
+initRenderer(QPainter *painter)
+{
+  renderer_.schem         = this;
+  renderer_.painter       = painter;
+  renderer_.prect         = rect();
+  renderer_.rect          = rect_;
+  renderer_.placementRect = placementGroup_->rect();
+  renderer_.selected      = false;
+  renderer_.inside        = false;
+}
+
+void
+Schematic::
+mousePressEvent(QMouseEvent *e)
+{
+  pressed_    = false;
+  pressPoint_ = QPointF(e->x(), e->y());
+
+  if      (e->button() == Qt::LeftButton) {
+    pressGate_      = nullptr;
+    pressPlacement_ = nullptr;
+
+    if      (moveGate_) {
+      pressGate_ = nearestGate(pressPoint_);
+
+      if (pressGate_) {
+        deselectAll();
+
+        pressGate_->setSelected(! pressGate_->isSelected());
+
+        update();
+      }
+    }
+    else if (movePlacement_) {
+      pressPlacement_ = nearestPlacementGroup(pressPoint_);
+
+      if (pressPlacement_) {
+        deselectAll();
+
+        pressPlacement_->setSelected(! pressPlacement_->isSelected());
+
+        update();
+      }
+    }
+    else if (moveConnection_) {
+      pressConnection_ = nearestConnection(pressPoint_);
+
+      if (pressConnection_) {
+        deselectAll();
+
+        pressConnection_->setSelected(! pressConnection_->isSelected());
+
+        update();
+      }
+    }
+
+    pressed_ = true;
+  }
+  else if (e->button() == Qt::MiddleButton) {
+    pressConnection_ = nearestConnection(pressPoint_);
+
+    if (pressConnection_) {
+      if (pressConnection_->isInput()) {
+        pressConnection_->setValue(! pressConnection_->getValue());
+
+        exec();
+      }
+    }
+  }
+  else if (e->button() == Qt::RightButton) {
+    QMenu *menu = new QMenu(this);
+
+    auto addAction = [&](QMenu *menu, const QString &name, const char *slotName) {
+      QAction *action = new QAction(name, menu);
+
+      connect(action, SIGNAL(triggered()), this, slotName);
+
+      menu->addAction(action);
+
+      return action;
+    };
+
+    addAction(menu, "Expand"  , SLOT(expandSlot  ()));
+    addAction(menu, "Collapse", SLOT(collapseSlot()));
+
+    menu->addSeparator();
+
+    addAction(menu, "Place", SLOT(placeSlot()));
+
+    QMenu *debugMenu = menu->addMenu("Debug");
+
+    addAction(debugMenu, "Memory Report", SLOT(memorySlot()));
+
+    menu->exec(mapToGlobal(e->pos()));
+  }
+}
+
+void
+Schematic::
+mouseMoveEvent(QMouseEvent *e)
+{
+  movePoint_ = QPointF(e->x(), e->y());
+
+  window_->setPos(renderer_.pixelToWindow(movePoint_));
+
+  double dx = std::abs(pressPoint_.x() - movePoint_.x());
+  double dy = std::abs(pressPoint_.y() - movePoint_.y());
+
+  if (dx < 1 && dy < 1)
+    return;
+
+  if (! pressed_) {
+    if      (moveGate_) {
+      Gate *gate = nearestGate(movePoint_);
+
+      if (gate != insideGate_) {
+        insideGate_ = gate;
+
+        update();
+      }
+    }
+    else if (movePlacement_) {
+      PlacementGroup *placement = nearestPlacementGroup(movePoint_);
+
+      if (placement != insidePlacement_) {
+        insidePlacement_ = placement;
+
+        update();
+      }
+    }
+    else if (moveConnection_) {
+      Connection *connection = nearestConnection(movePoint_);
+
+      if (connection != insideConnection_) {
+        insideConnection_ = connection;
+
+        update();
+      }
+    }
+
+    return;
+  }
+
+  if      (pressGate_) {
+    QPointF p1 = renderer_.pixelToWindow(QPointF(pressPoint_.x(), pressPoint_.y()));
+    QPointF p2 = renderer_.pixelToWindow(QPointF(movePoint_ .x(), movePoint_ .y()));
+
+    moveGate(pressGate_, QPointF(p2.x() - p1.x(), p2.y() - p1.y()));
+  }
+  else if (pressPlacement_) {
+    QPointF p1 = renderer_.pixelToWindow(QPointF(pressPoint_.x(), pressPoint_.y()));
+    QPointF p2 = renderer_.pixelToWindow(QPointF(movePoint_ .x(), movePoint_ .y()));
+
+    pressPlacement_->setRect(pressPlacement_->rect().translated(p2.x() - p1.x(), p2.y() - p1.y()));
+
+    calcBounds();
+
+    redraw();
+  }
+
+  pressPoint_ = movePoint_;
+}
+
+void
+Schematic::
+mouseReleaseEvent(QMouseEvent *e)
+{
+  mouseMoveEvent(e);
+
+  pressed_ = false;
+}
+
+void
+Schematic::
+keyPressEvent(QKeyEvent *e)
+{
+  if      (e->key() == Qt::Key_Plus)
+    renderer_.displayTransform.zoomIn();
+  else if (e->key() == Qt::Key_Minus)
+    renderer_.displayTransform.zoomOut();
+  else if (e->key() == Qt::Key_Left)
+    renderer_.displayTransform.panLeft();
+  else if (e->key() == Qt::Key_Right)
+    renderer_.displayTransform.panRight();
+  else if (e->key() == Qt::Key_Up)
+    renderer_.displayTransform.panUp();
+  else if (e->key() == Qt::Key_Down)
+    renderer_.displayTransform.panDown();
+  else if (e->key() == Qt::Key_Home)
+    renderer_.displayTransform.reset();
+  else if (e->key() == Qt::Key_Greater) {
+    Gates gates;
+
+    selectedGates(gates);
+
+    for (auto &gate : gates)
+      gate->nextOrient();
+  }
+  else if (e->key() == Qt::Key_Less) {
+    Gates gates;
+
+    selectedGates(gates);
+
+    for (auto &gate : gates)
+      gate->prevOrient();
+  }
+  else if (e->key() == Qt::Key_F) {
+    Gates gates;
+
+    selectedGates(gates);
+
+    for (auto &gate : gates)
+      gate->setFlipped(! gate->isFlipped());
+  }
+  else if (e->key() == Qt::Key_P) {
+    // overlay only (setter repaints) so keep routes
+    setShowPaintProfile(! isShowPaintProfile());
+
+    return;
+  }
+
+  redraw();
+}
+
+void
+Schematic::
+deselectAll()
+{
+  Gates selGates;
+
+  selectedGates(selGates);
+
+  for (auto &gate : selGates)
+    gate->setSelected(false);
+
+  Connections selConnections;
+
+  selectedConnections(selConnections);
+
+  for (auto &connection : selConnections)
+    connection->setSelected(false);
+
+  PlacementGroups selPlacementGroups;
+
+  selectedPlacementGroups(selPlacementGroups);
+
+  for (auto &placementGroup : selPlacementGroups)
+    placementGroup->setSelected(false);
+}
+
+void
+Schematic::
+expandSlot()
+{
+  resetObjs();
+
+  PlacementGroups expandGroups;
+
+  PlacementGroups selPlacementGroups;
+
+  selectedPlacementGroups(selPlacementGroups);
+
+  if (! selPlacementGroups.empty()) {
+    for (auto &placementGroup : selPlacementGroups) {
+      if (placementGroup->expandName() != "")
+        expandGroups.push_back(placementGroup);
+    }
+  }
+  else {
+    Gates selGates;
+
+    selectedGates(selGates);
+
+    if (! selGates.empty()) {
+      for (auto &gate : selGates) {
+        PlacementGroup *placementGroup = gate->placementGroup();
+
+        if (placementGroup->expandName() != "")
+          expandGroups.push_back(placementGroup);
+      }
+    }
+    else {
+      for (auto &placementGroupData : placementGroup_->placementGroups()) {
+        PlacementGroup *placementGroup = placementGroupData.placementGroup;
+
+        if (placementGroup->expandName() != "")
+          expandGroups.push_back(placementGroup);
+      }
+    }
+  }
+
+  //---
+
+  PlacementGroups newPlacementGroups;
+
+  for (auto &placementGroup : expandGroups) {
+    PlacementGroup *parentGroup = placementGroup->parent();
+
+    bool rc = execGate(parentGroup, placementGroup->expandName());
+    assert(rc);
+
+    copyRamCellState(placementGroup, parentGroup->placementGroups().back().placementGroup);
+
+    PlacementGroup *newPlacementGroup =
+      parentGroup->replacePlacementGroup(this, placementGroup);
+
+    newPlacementGroups.push_back(newPlacementGroup);
+  }
+
+  //---
+
+  for (auto &placementGroup : newPlacementGroups)
+    placementGroup->place();
+
+  calcBounds();
+
+  redraw();
+}
+
+void
+Schematic::
+collapseSlot()
+{
+  resetObjs();
+
+  PlacementGroups selPlacementGroups;
+
+  selectedPlacementGroups(selPlacementGroups);
+
+  PlacementGroups collapseGroups;
+
+  if (! selPlacementGroups.empty()) {
+    for (auto &placementGroup : selPlacementGroups) {
+      if (placementGroup->collapseName() != "")
+        collapseGroups.push_back(placementGroup);
+    }
+  }
+  else {
+    Gates selGates;
+
+    selectedGates(selGates);
+
+    if (! selGates.empty()) {
+      for (auto &gate : selGates) {
+        PlacementGroup *placementGroup = gate->placementGroup();
+
+        if (placementGroup->collapseName() != "")
+          collapseGroups.push_back(placementGroup);
+      }
+    }
+    else {
+      for (auto &placementGroupData : placementGroup_->placementGroups()) {
+        PlacementGroup *placementGroup = placementGroupData.placementGroup;
+
+        if (placementGroup->collapseName() != "")
+          collapseGroups.push_back(placementGroup);
+      }
+    }
+  }
+
+  //---
+
+  PlacementGroups newPlacementGroups;
+
+  for (auto &placementGroup : collapseGroups) {
+    PlacementGroup *parentGroup = placementGroup->parent();
+
+    bool rc = execGate(parentGroup, placementGroup->collapseName());
+    assert(rc);
+
+    copyRamCellState(placementGroup, parentGroup->placementGroups().back().placementGroup);
+
+    PlacementGroup *newPlacementGroup =
+      parentGroup->replacePlacementGroup(this, placementGroup);
+
+    newPlacementGroups.push_back(newPlacementGroup);
+  }
+
+  //---
+
+  for (auto &placementGroup : newPlacementGroups)
+    placementGroup->place();
+
+  calcBounds();
+
+  redraw();
+}
+
+void
+Schematic::
+placeSlot()
+{
+  place();
+
+  redraw();
+}
+
+void
+Schematic::
+memorySlot()
+{
+  printMemory();
+
+  if (! memoryPanel_)
+    memoryPanel_ = new MemoryPanel(this);
+
+  memoryPanel_->updateLines();
+
+  memoryPanel_->show();
+  memoryPanel_->raise();
+}
+
+void
+Schematic::
+resetObjs()
+{
+  pressGate_        = nullptr;
+  pressPlacement_   = nullptr;
+  insideGate_       = nullptr;
+  insidePlacement_  = nullptr;
+  insideConnection_ = nullptr;
+}
+
+void
+Schematic::
+redraw()
+{
+  changed_ = true;
+
+  invalidateConnections();
+
+  update();
+}
+
+void
+Schematic::
+redrawValues()
+{
+  // values changed so redraw using current connection lines
+  changed_ = true;
+
+  update();
+}
+
+void
+Schematic::
+routeBench(int n)
+{
+  // size to default and draw gates to place ports
+  resize(sizeHint());
+
+  renderer_.displayRange.setEqualScale(true);
+
+  renderer_.displayRange.setPixelRange(0, 0, this->width() - 1, this->height() - 1);
+
+  image_ = QImage(size(), QImage::Format_ARGB32);
+
+  calcBounds();
+
+  QPainter ipainter(&image_);
+
+  initRenderer(&ipainter);
+
+  for (const auto &gate : gates_)
+    gate->draw(&renderer_);
+
+  //---
+
+  // time routing of all (non bus) connections
+  int nc = 0;
+
+  for (const auto &connection : connections_) {
+    if (! connection->bus() && connection->anyPorts())
+      ++nc;
+  }
+
+  auto t1 = std::chrono::steady_clock::now();
+
+  for (int i = 0; i < n; ++i) {
+    invalidateConnections();
+
+    routeConnections();
+  }
+
+  auto t2 = std::chrono::steady_clock::now();
+
+  double ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+  std::cerr << "Routed " << nc << " connections x " << n << " in " << ms << "ms (" <<
+               (nc > 0 ? 1000.0*ms/(double(nc)*n) : 0.0) << "us per connection, " <<
+               routeChannels_.numChannels() << " channels)\n";
+
+  renderer_.painter = nullptr;
+}
+
+bool
+Schematic::
+renderImage(const QString &filename, const QSize &size, double zoom)
+{
+  using Phase = PaintProfile::Phase;
+
+  Trace::Scope trace("paint", "Schematic::renderImage");
+
+  // size to image (widget not shown) and fit to bounds, zoomed about center
+  resize(size);
+
+  renderer_.displayRange.setEqualScale(true);
+
+  renderer_.displayRange.setPixelRange(0, 0, size.width() - 1, size.height() - 1);
+
+  renderer_.displayTransform.reset();
+
+  invalidateConnections();
+
+  calcBounds();
+
+  if (zoom > 0.0) {
+    QPointF c = rect_.center();
+
+    double w = rect_.width ()/zoom;
+    double h = rect_.height()/zoom;
+
+    renderer_.displayRange.setWindowRange(c.x() - w/2, c.y() - h/2, c.x() + w/2, c.y() + h/2);
+  }
+
+  //---
+
+  // draw using same code as paint (first draw routes connections)
+  QImage image(size, QImage::Format_ARGB32);
+
+  paintProfile_.startFrame();
+
+  auto t1 = std::chrono::steady_clock::now();
+
+  {
+    QPainter ipainter(&image);
+
+    drawContents(&ipainter);
+  }
+
+  auto t2 = std::chrono::steady_clock::now();
+
+  renderer_.painter = nullptr;
+
+  // widget image needs redraw for new range
+  changed_ = true;
+
+  //---
+
+  double ms      = std::chrono::duration<double, std::milli>(t2 - t1).count();
+  double routeMs = paintProfile_.lastTime(Phase::ROUTE);
+
+  std::cerr << "Rendered " << gates_.size() << " gates, " << connections_.size() <<
+               " connections (" << size.width() << "x" << size.height() << ", zoom " <<
+               zoom << ") in " << ms << "ms (route " << routeMs << "ms, raster " <<
+               std::max(ms - routeMs, 0.0) << "ms)\n";
+
+  for (const auto &line : paintProfile_.lines())
+    std::cerr << "  " << line.toStdString() << "\n";
+
+  return image.save(filename, "PNG");
+}
+
+void
+Schematic::
+invalidateConnections()
+{
+  for (auto &connection : connections_)
+    connection->invalidateLines();
+
+  routeChannels_.clear();
+}
+
+void
+Schematic::
+routeConnections()
+{
+  // route all unrouted (non bus) connections in one pass with largest fanout first
+  // so larger nets get first choice of the shared line channels
+  Connections connections;
+
+  for (const auto &connection : connections_) {
+    if (! connection->bus() && connection->anyPorts() && ! connection->isLinesValid())
+      connections.push_back(connection);
+  }
+
+  std::stable_sort(connections.begin(), connections.end(),
+    [](const Connection *c1, const Connection *c2) {
+      return (c1->inPorts().size() + c1->outPorts().size() >
+              c2->inPorts().size() + c2->outPorts().size());
+    });
+
+  for (const auto &connection : connections)
+    connection->updateLines(&renderer_);
+}
+
+//---
+
+// layout cache file format (native byte order):
+//   header  : magic, version, layout hash
+//   gates   : count, (rect, orientation, flipped) per gate
+//   groups  : count, (place size, rows, columns) per placement group (depth first)
+//   routes  : pixel width and height, view mapping, count, (line count, lines) per connection
+static const uint32_t layoutCacheMagic   = 0x4C534351; // CQSL
+static const uint32_t layoutCacheVersion = 3;
+
+QString
+Schematic::
+layoutCacheFile(const QString &buildName) const
+{
+  QString dir = (getenv("CQSCHEM_CACHE_DIR") ? QString(getenv("CQSCHEM_CACHE_DIR")) :
+                                              QDir::tempPath());
+
+  return dir + "/CQSchem_" + (buildName != "" ? buildName : QString("default")) + ".layout";
+}
+
+uint64_t
+Schematic::
+calcLayoutHash() const
+{
+  // FNV-1a hash of everything which affects layout and routing (not positions)
+  uint64_t h = 14695981039346656037ULL;
+
+  auto addData = [&](const void *data, size_t n) {
+    auto *c = static_cast<const uchar *>(data);
+
+    for (size_t i = 0; i < n; ++i) {
+      h ^= c[i];
+      h *= 1099511628211ULL;
+    }
+  };
+
+  auto addInt = [&](int i) { addData(&i, sizeof(i)); };
+  auto addReal = [&](double r) { addData(&r, sizeof(r)); };
+
+  auto addString = [&](const QString &str) {
+    QByteArray ba = str.toUtf8();
+
+    addInt(ba.size());
+    addData(ba.constData(), size_t(ba.size()));
+  };
+
+  addInt(int(layoutCacheVersion));
+
+  addInt(int(gates_.size()));
+
+  for (const auto &gate : gates_) {
+    addString(gate->name());
+
+    addInt (int(gate->orientation()));
+    addInt (gate->isFlipped());
+    addReal(gate->width ());
+    addReal(gate->height());
+
+    addInt(int(gate->inputs ().size()));
+    addInt(int(gate->outputs().size()));
+
+    // port names and attached nets (rewired nets change routes)
+    auto addPort = [&](const Port *port) {
+      addString(port->name());
+
+      addInt(port->connection() ? port->connection()->schemInd() : -1);
+    };
+
+    for (const auto &port : gate->inputs())
+      addPort(port);
+
+    for (const auto &port : gate->outputs())
+      addPort(port);
+  }
+
+  addInt(int(connections_.size()));
+
+  for (const auto &connection : connections_) {
+    addString(connection->name());
+
+    addInt(int(connection->inPorts ().size()));
+    addInt(int(connection->outPorts().size()));
+    addInt(connection->bus() != nullptr);
+  }
+
+  // bus membership and gate anchor
+  addInt(int(buses_.size()));
+
+  for (const auto &bus : buses_) {
+    addInt(bus->n());
+    addInt(bus->gate() ? bus->gate()->schemInd() : -1);
+
+    for (int i = 0; i < bus->n(); ++i) {
+      Connection *connection = bus->connection(i);
+
+      addInt(connection ? connection->schemInd() : -1);
+    }
+  }
+
+  std::function<void (const PlacementGroup *)> addPlacementGroup =
+    [&](const PlacementGroup *placementGroup) {
+    addInt(int(placementGroup->placement()));
+
+    addInt(int(placementGroup->gates().size()));
+
+    for (const auto &gateData : placementGroup->gates()) {
+      addInt(gateData.r); addInt(gateData.c); addInt(gateData.nr); addInt(gateData.nc);
+      addInt(int(gateData.alignment));
+    }
+
+    addInt(int(placementGroup->placementGroups().size()));
+
+    for (const auto &placementGroupData : placementGroup->placementGroups()) {
+      addInt(placementGroupData.r ); addInt(placementGroupData.c );
+      addInt(placementGroupData.nr); addInt(placementGroupData.nc);
+      addInt(int(placementGroupData.alignment));
+
+      addPlacementGroup(placementGroupData.placementGroup);
+    }
+  };
+
+  addPlacementGroup(placementGroup_);
+
+  return h;
+}
+
+bool
+Schematic::
+loadLayoutCache(const QString &buildName)
+{
+  // hash of constructed (unplaced) layout identifies cache file contents
+  layoutHash_ = calcLayoutHash();
+
+  delete routeCacheFile_;
+
+  routeCacheFile_ = nullptr;
+  routeCacheData_ = nullptr;
+  routeCacheSize_ = 0;
+
+  auto *file = new QFile(layoutCacheFile(buildName));
+
+  if (! file->open(QIODevice::ReadOnly)) {
+    delete file;
+    return false;
+  }
+
+  qint64 size = file->size();
+
+  const uchar *data = (size > 0 ? file->map(0, size) : nullptr);
+
+  if (! data) {
+    delete file;
+    return false;
+  }
+
+  //---
+
+  qint64 pos = 0;
+
+  auto read = [&](void *p, size_t n) {
+    if (pos + qint64(n) > size)
+      return false;
+
+    memcpy(p, data + pos, n);
+
+    pos += qint64(n);
+
+    return true;
+  };
+
+  uint32_t magic = 0, version = 0;
+  uint64_t hash = 0;
+
+  if (! read(&magic, sizeof(magic)) || ! read(&version, sizeof(version)) ||
+      ! read(&hash, sizeof(hash)) || magic != layoutCacheMagic ||
+      version != layoutCacheVersion || hash != layoutHash_) {
+    delete file;
+    return false;
+  }
+
+  //---
+
+  // read all geometry before applying so bad file leaves layout unchanged
+  struct GateLayout {
+    double  r[4]   { 0, 0, 0, 0 };
+    int32_t orient { 0 };
+    int32_t flip   { 0 };
+  };
+
+  struct PlacementLayout {
+    double  size[2] { 0, 0 };
+    int32_t nr      { 0 };
+    int32_t nc      { 0 };
+  };
+
+  std::vector<PlacementGroup *> placementGroups;
+
+  std::function<void (PlacementGroup *)> addPlacementGroup =
+    [&](PlacementGroup *placementGroup) {
+    placementGroups.push_back(placementGroup);
+
+    for (const auto &placementGroupData : placementGroup->placementGroups())
+      addPlacementGroup(placementGroupData.placementGroup);
+  };
+
+  addPlacementGroup(placementGroup_);
+
+  uint32_t ng = 0, npg = 0;
+
+  std::vector<GateLayout>      gateLayouts;
+  std::vector<PlacementLayout> placementLayouts;
+
+  bool rc = (read(&ng, sizeof(ng)) && ng == gates_.size());
+
+  if (rc) {
+    gateLayouts.resize(ng);
+
+    rc = read(gateLayouts.data(), ng*sizeof(GateLayout));
+  }
+
+  if (rc)
+    rc = (read(&npg, sizeof(npg)) && npg == placementGroups.size());
+
+  if (rc) {
+    placementLayouts.resize(npg);
+
+    rc = read(placementLayouts.data(), npg*sizeof(PlacementLayout));
+  }
+
+  if (! rc) {
+    delete file;
+    return false;
+  }
+
+  //---
+
+  for (uint i = 0; i < ng; ++i) {
+    const GateLayout &gl = gateLayouts[i];
+
+    Gate *gate = gates_[i];
+
+    gate->setRect       (QRectF(gl.r[0], gl.r[1], gl.r[2], gl.r[3]));
+    gate->setOrientation(static_cast<Gate::Orientation>(gl.orient));
+    gate->setFlipped    (gl.flip);
+  }
+
+  for (uint i = 0; i < npg; ++i) {
+    const PlacementLayout &pl = placementLayouts[i];
+
+    PlacementGroup *placementGroup = placementGroups[i];
+
+    placementGroup->setPlaceSize (QSizeF(pl.size[0], pl.size[1]));
+    placementGroup->setNumRows   (pl.nr);
+    placementGroup->setNumColumns(pl.nc);
+  }
+
+  calcBounds();
+
+  //---
+
+  // keep file mapped until routes are applied on first paint
+  routeCacheFile_ = file;
+  routeCacheData_ = data + pos;
+  routeCacheSize_ = size - pos;
+
+  return true;
+}
+
+bool
+Schematic::
+saveLayoutCache(const QString &buildName)
+{
+  if (layoutHash_ == 0)
+    layoutHash_ = calcLayoutHash();
+
+  QByteArray data;
+
+  auto write = [&](const void *p, size_t n) {
+    data.append(static_cast<const char *>(p), int(n));
+  };
+
+  write(&layoutCacheMagic  , sizeof(layoutCacheMagic  ));
+  write(&layoutCacheVersion, sizeof(layoutCacheVersion));
+  write(&layoutHash_       , sizeof(layoutHash_       ));
+
+  //---
+
+  uint32_t ng = uint32_t(gates_.size());
+
+  write(&ng, sizeof(ng));
+
+  for (const auto &gate : gates_) {
+    const QRectF &r = gate->rect();
+
+    double  rv[4]  = { r.x(), r.y(), r.width(), r.height() };
+    int32_t orient = int32_t(gate->orientation());
+    int32_t flip   = gate->isFlipped();
+
+    write(rv, sizeof(rv)); write(&orient, sizeof(orient)); write(&flip, sizeof(flip));
+  }
+
+  //---
+
+  std::vector<const PlacementGroup *> placementGroups;
+
+  std::function<void (const PlacementGroup *)> addPlacementGroup =
+    [&](const PlacementGroup *placementGroup) {
+    placementGroups.push_back(placementGroup);
+
+    for (const auto &placementGroupData : placementGroup->placementGroups())
+      addPlacementGroup(placementGroupData.placementGroup);
+  };
+
+  addPlacementGroup(placementGroup_);
+
+  uint32_t npg = uint32_t(placementGroups.size());
+
+  write(&npg, sizeof(npg));
+
+  for (const auto &placementGroup : placementGroups) {
+    QSizeF size = placementGroup->placeSize();
+
+    double  sv[2] = { size.width(), size.height() };
+    int32_t nr    = placementGroup->numRows();
+    int32_t nc    = placementGroup->numColumns();
+
+    write(sv, sizeof(sv)); write(&nr, sizeof(nr)); write(&nc, sizeof(nc));
+  }
+
+  //---
+
+  // routes are only saved if all routed for current pixel size
+  bool routed = true;
+
+  for (const auto &connection : connections_) {
+    if (! connection->bus() && connection->anyPorts() && ! connection->isLinesValid())
+      routed = false;
+  }
+
+  int32_t  pw = (routed ? width () : 0);
+  int32_t  ph = (routed ? height() : 0);
+  uint32_t nc = (routed ? uint32_t(connections_.size()) : 0);
+
+  double view[4];
+
+  routeView(view);
+
+  write(&pw, sizeof(pw)); write(&ph, sizeof(ph)); write(view, sizeof(view));
+  write(&nc, sizeof(nc));
+
+  if (routed) {
+    for (const auto &connection : connections_) {
+      const Connection::Lines &lines = connection->lines();
+
+      uint32_t nl = uint32_t(lines.size());
+
+      write(&nl, sizeof(nl));
+
+      for (const auto &line : lines) {
+        int32_t ind   = line.ind;
+        double  lv[4] = { line.start.x(), line.start.y(), line.end.x(), line.end.y() };
+
+        write(&ind, sizeof(ind)); write(lv, sizeof(lv));
+      }
+    }
+  }
+
+  //---
+
+  QFile file(layoutCacheFile(buildName));
+
+  saveLayoutCacheName_ = "";
+
+  if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  return (file.write(data) == data.size());
+}
+
+void
+Schematic::
+routeView(double view[4]) const
+{
+  // pixel position of window origin and unit point (routes are in pixels so only
+  // reusable with same window to pixel mapping, i.e. same size, zoom and pan)
+  QPointF p1 = renderer_.windowToPixel(QPointF(0, 0));
+  QPointF p2 = renderer_.windowToPixel(QPointF(1, 1));
+
+  view[0] = p1.x(); view[1] = p1.y();
+  view[2] = p2.x(); view[3] = p2.y();
+}
+
+void
+Schematic::
+applyCachedRoutes()
+{
+  if (! routeCacheFile_)
+    return;
+
+  qint64 pos = 0;
+
+  auto read = [&](void *p, size_t n) {
+    if (pos + qint64(n) > routeCacheSize_)
+      return false;
+
+    memcpy(p, routeCacheData_ + pos, n);
+
+    pos += qint64(n);
+
+    return true;
+  };
+
+  int32_t  pw = 0, ph = 0;
+  double   view[4] = { 0, 0, 0, 0 };
+  uint32_t nc = 0;
+
+  double view1[4];
+
+  routeView(view1);
+
+  auto sameView = [&]() {
+    for (int i = 0; i < 4; ++i) {
+      if (std::abs(view[i] - view1[i]) > 1E-3)
+        return false;
+    }
+
+    return true;
+  };
+
+  // routes are in pixels so only valid for same widget size and view
+  if (read(&pw, sizeof(pw)) && read(&ph, sizeof(ph)) && read(view, sizeof(view)) &&
+      read(&nc, sizeof(nc)) && pw == width() && ph == height() && sameView() &&
+      nc == connections_.size()) {
+    Connection::Lines lines;
+
+    bool rc = true;
+
+    for (const auto &connection : connections_) {
+      uint32_t nl = 0;
+
+      if (! read(&nl, sizeof(nl))) { rc = false; break; }
+
+      lines.clear();
+
+      for (uint32_t i = 0; i < nl; ++i) {
+        int32_t ind   = 0;
+        double  lv[4] = { 0, 0, 0, 0 };
+
+        if (! read(&ind, sizeof(ind)) || ! read(lv, sizeof(lv))) { rc = false; break; }
+
+        lines.push_back(Connection::Line(ind, QPointF(lv[0], lv[1]), QPointF(lv[2], lv[3])));
+      }
+
+      if (! rc)
+        break;
+
+      if (! connection->bus() && connection->anyPorts())
+        connection->setLines(&renderer_, lines);
+    }
+
+    if (! rc)
+      invalidateConnections();
+  }
+
+  delete routeCacheFile_;
+
+  routeCacheFile_ = nullptr;
+  routeCacheData_ = nullptr;
+  routeCacheSize_ = 0;
+}
+
+//---
+
+// gate types which can be created by name (netlist files)
+struct GateType {
+  using Create = std::function<Gate *(const QString &name, int p1, int p2)>;
+  using Valid  = std::function<bool (int p1, int p2)>;
+
+  QString         name;
+  std::type_index type;
+  Create          create;
+  size_t          size { 0 }; // object bytes
+  Valid           valid;      // check parameters before create (null if none)
+
+  bool isValid(int p1, int p2) const { return (! valid || valid(p1, p2)); }
+};
+
+using GateTypes = std::vector<GateType>;
+
+template<typename T>
+static GateType
+gateTypeT(const QString &name)
+{
+  return GateType{name, std::type_index(typeid(T)),
+                  [](const QString &name, int, int) -> Gate * { return new T(name); },
+                  sizeof(T), GateType::Valid()};
+}
+
+static const GateTypes &
+gateTypes()
+{
+  static GateTypes gateTypes;
+
+  if (gateTypes.empty()) {
+    gateTypes.push_back(gateTypeT<NandGate       >("nand"       ));
+    gateTypes.push_back(gateTypeT<NotGate        >("not"        ));
+    gateTypes.push_back(gateTypeT<AndGate        >("and"        ));
+    gateTypes.push_back(gateTypeT<And3Gate       >("and3"       ));
+    gateTypes.push_back(gateTypeT<And4Gate       >("and4"       ));
+    gateTypes.push_back(gateTypeT<And8Gate       >("and8"       ));
+    gateTypes.push_back(gateTypeT<OrGate         >("or"         ));
+    gateTypes.push_back(gateTypeT<Or8Gate        >("or8"        ));
+    gateTypes.push_back(gateTypeT<XorGate        >("xor"        ));
+    gateTypes.push_back(gateTypeT<MemoryGate     >("memory"     ));
+    gateTypes.push_back(gateTypeT<Memory8Gate    >("memory8"    ));
+    gateTypes.push_back(gateTypeT<EnablerGate    >("enabler"    ));
+    gateTypes.push_back(gateTypeT<RegisterGate   >("register"   ));
+    gateTypes.push_back(gateTypeT<Decoder4Gate   >("decoder4"   ));
+    gateTypes.push_back(gateTypeT<Decoder8Gate   >("decoder8"   ));
+    gateTypes.push_back(gateTypeT<Decoder16Gate  >("decoder16"  ));
+    gateTypes.push_back(gateTypeT<Decoder256Gate >("decoder256" ));
+    gateTypes.push_back(gateTypeT<LShiftGate     >("lshift"     ));
+    gateTypes.push_back(gateTypeT<RShiftGate     >("rshift"     ));
+    gateTypes.push_back(gateTypeT<InverterGate   >("inverter"   ));
+    gateTypes.push_back(gateTypeT<AnderGate      >("ander"      ));
+    gateTypes.push_back(gateTypeT<OrerGate       >("orer"       ));
+    gateTypes.push_back(gateTypeT<XorerGate      >("xorer"      ));
+    gateTypes.push_back(gateTypeT<AdderGate      >("adder"      ));
+    gateTypes.push_back(gateTypeT<Adder8Gate     >("adder8"     ));
+    gateTypes.push_back(gateTypeT<ComparatorGate >("comparator" ));
+    gateTypes.push_back(gateTypeT<Comparator8Gate>("comparator8"));
+    gateTypes.push_back(gateTypeT<Bus0Gate       >("bus0"       ));
+    gateTypes.push_back(gateTypeT<Bus1Gate       >("bus1"       ));
+    gateTypes.push_back(gateTypeT<AluGate        >("alu"        ));
+    gateTypes.push_back(gateTypeT<ClkESGate      >("clk_es"     ));
+    gateTypes.push_back(gateTypeT<StepperGate    >("stepper"    ));
+
+    // parameterized types (p1, p2 are delay and cycle, rows and columns)
+    gateTypes.push_back(GateType{"clk", std::type_index(typeid(ClkGate)),
+      [](const QString &name, int p1, int p2) -> Gate * {
+        auto *gate = new ClkGate(name);
+        gate->setDelay(p1); gate->setCycle(p2);
+        return gate; }, sizeof(ClkGate),
+      [](int p1, int p2) { return (p1 >= 0 && p2 >= 0); }});
+    gateTypes.push_back(GateType{"ram_array", std::type_index(typeid(RamArrayGate)),
+      [](const QString &name, int p1, int p2) -> Gate * {
+        return new RamArrayGate(name, p1, p2); }, sizeof(RamArrayGate),
+      [](int p1, int p2) { return (p1 >= 1 && p1 <= 256 && p2 >= 1 && p2 <= 256); }});
+  }
+
+  return gateTypes;
+}
+
+// index of gate type for gate (-1 if not creatable) and its parameters
+static int
+gateTypeIndex(const Gate *gate, int &p1, int &p2)
+{
+  p1 = 0; p2 = 0;
+
+  if      (auto *clkGate = dynamic_cast<const ClkGate *>(gate)) {
+    p1 = clkGate->delay(); p2 = clkGate->cycle();
+  }
+  else if (auto *ramGate = dynamic_cast<const RamArrayGate *>(gate)) {
+    p1 = ramGate->numRows(); p2 = ramGate->numColumns();
+  }
+
+  const GateTypes &types = gateTypes();
+
+  std::type_index type(typeid(*gate));
+
+  for (uint i = 0; i < types.size(); ++i) {
+    if (types[i].type == type)
+      return int(i);
+  }
+
+  return -1;
+}
+
+// index of named gate type (-1 if not found)
+static int
+gateTypeIndex(const QString &name)
+{
+  const GateTypes &types = gateTypes();
+
+  for (uint i = 0; i < types.size(); ++i) {
+    if (types[i].name == name)
+      return int(i);
+  }
+
+  return -1;
+}
+
+std::vector<QString>
+Schematic::
+memoryLines() const
+{
+  // gate object sizes from creatable types
+  std::unordered_map<std::type_index, size_t> typeSizes;
+
+  for (const auto &type : gateTypes())
+    typeSizes[type.type] = type.size;
+
+  auto gateSize = [&](const Gate *gate) {
+    auto p = typeSizes.find(std::type_index(typeid(*gate)));
+
+    return (p != typeSizes.end() ? (*p).second : sizeof(Gate));
+  };
+
+  //---
+
+  struct MemUsage {
+    long   count { 0 };
+    size_t bytes { 0 };
+
+    void add(size_t n) { ++count; bytes += n; }
+  };
+
+  std::map<QString, MemUsage> gateUsage;
+
+  MemUsage portUsage, portNameUsage, connUsage, lineUsage, busUsage, groupUsage;
+
+  // implicitly shared (interned) strings only count their data once
+  std::set<const void *> strings;
+
+  auto sharedStringBytes = [&](const QString &str) {
+    return (strings.insert(str.constData()).second ? stringBytes(str) : size_t(0));
+  };
+
+  for (const auto &gate : gates_) {
+    if (! gate) continue;
+
+    gateUsage[gateClassName(gate)].add(gateSize(gate) + gate->heapBytes());
+
+    auto addPorts = [&](const Gate::Ports &ports) {
+      for (const auto &port : ports) {
+        portUsage    .add(sizeof(Port)); // includes name and ppos_
+        portNameUsage.add(sharedStringBytes(port->name()));
+      }
+    };
+
+    addPorts(gate->inputs ());
+    addPorts(gate->outputs());
+  }
+
+  for (const auto &connection : connections_) {
+    if (! connection) continue;
+
+    connUsage.add(sizeof(Connection) + (connection->inPorts ().capacity() +
+                                        connection->outPorts().capacity())*sizeof(Port *));
+
+    lineUsage.add(connection->lines().capacity()*sizeof(Connection::Line));
+  }
+
+  for (const auto &bus : buses_) {
+    if (! bus) continue;
+
+    busUsage.add(sizeof(Bus) + sharedStringBytes(bus->name()) +
+                 size_t(bus->n())*sizeof(Connection *));
+  }
+
+  std::function<void(const PlacementGroup *)> addGroup = [&](const PlacementGroup *group) {
+    groupUsage.add(sizeof(PlacementGroup) +
+                   group->gates          ().capacity()*sizeof(PlacementGroup::GateData) +
+                   group->connections    ().capacity()*sizeof(Connection *) +
+                   group->buses          ().capacity()*sizeof(Bus *) +
+                   group->placementGroups().capacity()*sizeof(PlacementGroup::PlacementGroupData) +
+                   sharedStringBytes(group->expandName()) +
+                   sharedStringBytes(group->collapseName()));
+
+    for (const auto &data : group->placementGroups())
+      addGroup(data.placementGroup);
+  };
+
+  addGroup(placementGroup_);
+
+  //---
+
+  std::vector<QString> lines;
+
+  size_t total = 0;
+
+  auto addLine = [&](const QString &name, long count, size_t bytes) {
+    lines.push_back(QString("%1 %2 %3").arg(name, -24).arg(count, 10).
+                      arg(double(bytes)/1024.0, 14, 'f', 1));
+
+    total += bytes;
+  };
+
+  lines.push_back(QString("%1 %2 %3").arg("Type", -24).arg("Count", 10).arg("KB", 14));
+
+  for (const auto &usage : gateUsage)
+    addLine(usage.first, usage.second.count, usage.second.bytes);
+
+  addLine("Port"            , portUsage    .count, portUsage    .bytes);
+  addLine("Port names"      , portNameUsage.count, portNameUsage.bytes);
+  addLine("Connection"      , connUsage    .count, connUsage    .bytes);
+  addLine("Connection lines", lineUsage    .count, lineUsage    .bytes);
+  addLine("Bus"             , busUsage     .count, busUsage     .bytes);
+  addLine("PlacementGroup"  , groupUsage   .count, groupUsage   .bytes);
+
+  addLine("Names", NameTable::numNames(), NameTable::numBytes());
+
+  addLine("Schematic arrays", 1, (gates_.capacity() + connections_.capacity() +
+                                  buses_.capacity())*sizeof(void *) +
+                                 simOps_.capacity()*sizeof(SimOp) +
+                                 toggles_.capacity()*sizeof(uint32_t));
+
+  if (waveform_)
+    addLine("Waveform history", 1, waveform_->memBytes());
+
+  addLine("Image cache", image_.isNull() ? 0 : 1, size_t(image_.sizeInBytes()));
+
+  addLine("Route cache (mapped)", routeCacheData_ ? 1 : 0, size_t(routeCacheSize_));
+
+  lines.push_back(QString("%1 %2 %3").arg("total", -24).arg("", 10).
+                    arg(double(total)/1024.0, 14, 'f', 1));
+
+  // gates, ports and connections are allocated from arena chunks
+  lines.push_back(QString("arena: %1 live objects in %2 KB").
+                    arg(long(arena_.numLive())).arg(double(arena_.numBytes())/1024.0, 0, 'f', 1));
+
+  return lines;
+}
+
+void
+Schematic::
+printMemory() const
+{
+  for (const auto &line : memoryLines())
+    std::cerr << line.toStdString() << "\n";
+}
+
+bool
+Schematic::
+setPerf(bool b)
+{
+  if (b && ! perfCounters_.isOpen() && ! perfCounters_.open()) {
+    std::cerr << "Hardware performance counters not available\n";
+
+    b = false;
+  }
+
+  if (! b)
+    perfCounters_.close();
+
+  perf_ = b;
+
+  return perf_;
+}
+
+void
+Schematic::
+startPerfBatch()
+{
+  if (! perf_ || perfBatch_)
+    return;
+
+  perfCounters_.start();
+
+  perfBatch_ = true;
+}
+
+void
+Schematic::
+stopPerfBatch()
+{
+  if (! perfBatch_)
+    return;
+
+  perfCounters_.stop();
+
+  perfBatch_ = false;
+}
+
+std::vector<QString>
+Schematic::
+perfLines() const
+{
+  using Counter = PerfCounters::Counter;
+
+  std::vector<QString> lines;
+
+  lines.push_back(QString("%1 ticks, %2 evals (gates, fused ops, AIG ands)").
+                    arg(perfTicks_).arg(perfEvals_));
+
+  lines.push_back(QString("%1 %2 %3").arg("Counter", -16).arg("Total", 16).arg("Per Eval", 12));
+
+  for (int i = 0; i < PerfCounters::numCounters; ++i) {
+    auto counter = Counter(i);
+
+    if (! perfCounters_.isAvailable(counter))
+      continue;
+
+    double value = double(perfCounters_.value(counter));
+
+    lines.push_back(QString("%1 %2 %3").arg(PerfCounters::counterName(counter), -16).
+      arg(value, 16, 'f', 0).arg(perfEvals_ > 0 ? value/double(perfEvals_) : 0.0, 12, 'f', 3));
+  }
+
+  uint64_t cycles = perfCounters_.value(Counter::CYCLES);
+
+  if (cycles > 0 && perfCounters_.isAvailable(Counter::INSTRUCTIONS))
+    lines.push_back(QString("IPC %1").
+      arg(double(perfCounters_.value(Counter::INSTRUCTIONS))/double(cycles), 0, 'f', 3));
+
+  return lines;
+}
+
+void
+Schematic::
+printPerf() const
+{
+  for (const auto &line : perfLines())
+    std::cerr << line.toStdString() << "\n";
+}
+
+//---
+
+// binary netlist file format (native byte order, all fields 32 bit, records read in place
+// from mapped file):
+//   header      : magic, version, file size, (offset, count) per section
+//   strings     : char offset per string (string 0 is empty)
+//   chars       : nul terminated utf8 string data
+//   types       : string per gate type used
+//   gates       : type, name, orientation, flipped, parameters, port net range
+//   port nets   : connection index (-1 if unconnected) per port (inputs then outputs)
+//   connections : name
+//   buses       : name, size, gate, flipped, position, offset, connection range
+//   bus nets    : connection index per bus bit
+//   groups      : placement, size, position in parent, names, contents (depth first,
+//                 group 0 is root and parent always before child)
+//   group gates : gate and position in group
+//   group nets  : connection index
+//   group buses : bus index
+static const uint32_t netlistMagic   = 0x4E534351; // CQSN
+static const uint32_t netlistVersion = 1;
+
+enum NetlistSection {
+  NETLIST_STRINGS,
+  NETLIST_CHARS,
+  NETLIST_TYPES,
+  NETLIST_GATES,
+  NETLIST_PORT_NETS,
+  NETLIST_CONNECTIONS,
+  NETLIST_BUSES,
+  NETLIST_BUS_NETS,
+  NETLIST_GROUPS,
+  NETLIST_GROUP_GATES,
+  NETLIST_GROUP_NETS,
+  NETLIST_GROUP_BUSES,
+  NETLIST_NUM_SECTIONS
+};
+
+struct NetlistHeader {
+  uint32_t magic   { netlistMagic };
+  uint32_t version { netlistVersion };
+  uint32_t size    { 0 };
+  uint32_t offset[NETLIST_NUM_SECTIONS];
+  uint32_t count [NETLIST_NUM_SECTIONS];
+};
+
+struct NetlistGate {
+  int32_t type, name, orient, flipped, p1, p2, portStart, numPorts;
+};
+
+struct NetlistBus {
+  int32_t name, n, gate, flipped, position;
+  float   offset;
+  int32_t netStart;
+};
+
+struct NetlistGroup {
+  int32_t parent, placement, nr, nc;
+  int32_t r, c, pnr, pnc, alignment;
+  int32_t expandName, collapseName, indexRow, indexCol;
+  int32_t gateStart, numGates, netStart, numNets, busStart, numBuses;
+};
+
+struct NetlistGroupGate {
+  int32_t gate, r, c, nr, nc, alignment;
+};
+
+bool
+Schematic::
+saveNetlist(const QString &filename)
+{
+  compactObjs();
+
+  //---
+
+  // strings
+  std::vector<int32_t> stringOffsets;
+  QByteArray           chars;
+  QHash<QString, int>  stringInd;
+
+  auto addString = [&](const QString &str) {
+    int ind = stringInd.value(str, -1);
+
+    if (ind < 0) {
+      ind = int(stringOffsets.size());
+
+      stringOffsets.push_back(int32_t(chars.size()));
+
+      chars.append(str.toUtf8());
+      chars.append('\0');
+
+      stringInd[str] = ind;
+    }
+
+    return int32_t(ind);
+  };
+
+  addString("");
+
+  //---
+
+  // gates
+  std::vector<int32_t>     types;
+  std::vector<int32_t>     typeInd(gateTypes().size(), -1);
+  std::vector<NetlistGate> gates;
+  std::vector<int32_t>     portNets;
+
+  for (const auto &gate : gates_) {
+    NetlistGate ng;
+
+    int p1, p2;
+
+    int type = gateTypeIndex(gate, p1, p2);
+
+    if (type < 0)
+      return false;
+
+    if (typeInd[uint(type)] < 0) {
+      typeInd[uint(type)] = int32_t(types.size());
+
+      types.push_back(addString(gateTypes()[uint(type)].name));
+    }
+
+    ng.type      = typeInd[uint(type)];
+    ng.name      = addString(gate->localName());
+    ng.orient    = int32_t(gate->orientation());
+    ng.flipped   = gate->isFlipped();
+    ng.p1        = p1;
+    ng.p2        = p2;
+    ng.portStart = int32_t(portNets.size());
+    ng.numPorts  = int32_t(gate->inputs().size() + gate->outputs().size());
+
+    for (int i = 0; i < ng.numPorts; ++i) {
+      Connection *connection = gate->portByIndex(i)->connection();
+
+      portNets.push_back(connection ? connection->schemInd() : -1);
+    }
+
+    gates.push_back(ng);
+  }
+
+  //---
+
+  // connections
+  std::vector<int32_t> connections;
+
+  for (const auto &connection : connections_)
+    connections.push_back(addString(connection->name()));
+
+  //---
+
+  // buses
+  std::vector<NetlistBus> buses;
+  std::vector<int32_t>    busNets;
+
+  for (const auto &bus : buses_) {
+    NetlistBus nb;
+
+    nb.name     = addString(bus->name());
+    nb.n        = bus->n();
+    nb.gate     = (bus->gate() ? bus->gate()->schemInd() : -1);
+    nb.flipped  = bus->isFlipped();
+    nb.position = int32_t(bus->position());
+    nb.offset   = float(bus->offset());
+    nb.netStart = int32_t(busNets.size());
+
+    for (int i = 0; i < bus->n(); ++i) {
+      Connection *connection = bus->connection(i);
+
+      busNets.push_back(connection ? connection->schemInd() : -1);
+    }
+
+    buses.push_back(nb);
+  }
+
+  //---
+
+  // placement groups
+  std::vector<NetlistGroup>     groups;
+  std::vector<NetlistGroupGate> groupGates;
+  std::vector<int32_t>          groupNets;
+  std::vector<int32_t>          groupBuses;
+
+  std::function<void (const PlacementGroup *, int, const PlacementGroup::PlacementGroupData *)>
+   addPlacementGroup = [&](const PlacementGroup *placementGroup, int parent,
+                           const PlacementGroup::PlacementGroupData *data) {
+    NetlistGroup ng;
+
+    ng.parent       = parent;
+    ng.placement    = int32_t(placementGroup->placement());
+    ng.nr           = placementGroup->numRows();
+    ng.nc           = placementGroup->numColumns();
+    ng.r            = (data ? data->r  : -1);
+    ng.c            = (data ? data->c  : -1);
+    ng.pnr          = (data ? data->nr : 1);
+    ng.pnc          = (data ? data->nc : 1);
+    ng.alignment    = int32_t(data ? data->alignment : Alignment::CENTER);
+    ng.expandName   = addString(placementGroup->expandName());
+    ng.collapseName = addString(placementGroup->collapseName());
+    ng.indexRow     = placementGroup->indexRow();
+    ng.indexCol     = placementGroup->indexColumn();
+    ng.gateStart    = int32_t(groupGates.size());
+    ng.numGates     = int32_t(placementGroup->gates().size());
+    ng.netStart     = int32_t(groupNets.size());
+    ng.numNets      = int32_t(placementGroup->connections().size());
+    ng.busStart     = int32_t(groupBuses.size());
+    ng.numBuses     = int32_t(placementGroup->buses().size());
+
+    for (const auto &gateData : placementGroup->gates())
+      groupGates.push_back(NetlistGroupGate{gateData.gate->schemInd(),
+        gateData.r, gateData.c, gateData.nr, gateData.nc, int32_t(gateData.alignment)});
+
+    for (const auto &connection : placementGroup->connections())
+      groupNets.push_back(connection->schemInd());
+
+    for (const auto &bus : placementGroup->buses())
+      groupBuses.push_back(bus->schemInd());
+
+    int ind = int(groups.size());
+
+    groups.push_back(ng);
+
+    for (const auto &placementGroupData : placementGroup->placementGroups())
+      addPlacementGroup(placementGroupData.placementGroup, ind, &placementGroupData);
+  };
+
+  addPlacementGroup(placementGroup_, -1, nullptr);
+
+  //---
+
+  NetlistHeader header;
+
+  QByteArray data;
+
+  data.append(reinterpret_cast<const char *>(&header), int(sizeof(header)));
+
+  auto addSection = [&](NetlistSection section, const void *p, size_t size, size_t n) {
+    // keep sections 4 byte aligned
+    while (data.size() % 4)
+      data.append('\0');
+
+    header.offset[section] = uint32_t(data.size());
+    header.count [section] = uint32_t(n);
+
+    if (n > 0)
+      data.append(static_cast<const char *>(p), int(size*n));
+  };
+
+  addSection(NETLIST_STRINGS    , stringOffsets.data(), sizeof(int32_t),
+             stringOffsets.size());
+  addSection(NETLIST_CHARS      , chars.constData()   , 1, size_t(chars.size()));
+  addSection(NETLIST_TYPES      , types.data()        , sizeof(int32_t), types.size());
+  addSection(NETLIST_GATES      , gates.data()        , sizeof(NetlistGate), gates.size());
+  addSection(NETLIST_PORT_NETS  , portNets.data()     , sizeof(int32_t), portNets.size());
+  addSection(NETLIST_CONNECTIONS, connections.data()  , sizeof(int32_t), connections.size());
+  addSection(NETLIST_BUSES      , buses.data()        , sizeof(NetlistBus), buses.size());
+  addSection(NETLIST_BUS_NETS   , busNets.data()      , sizeof(int32_t), busNets.size());
+  addSection(NETLIST_GROUPS     , groups.data()       , sizeof(NetlistGroup), groups.size());
+  addSection(NETLIST_GROUP_GATES, groupGates.data()   , sizeof(NetlistGroupGate),
+             groupGates.size());
+  addSection(NETLIST_GROUP_NETS , groupNets.data()    , sizeof(int32_t), groupNets.size());
+  addSection(NETLIST_GROUP_BUSES, groupBuses.data()   , sizeof(int32_t), groupBuses.size());
+
+  header.size = uint32_t(data.size());
+
+  data.replace(0, int(sizeof(header)), reinterpret_cast<const char *>(&header),
+               int(sizeof(header)));
+
+  //---
+
+  QFile file(filename);
+
+  if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  return (file.write(data) == data.size());
+}
+
+bool
+Schematic::
+loadNetlist(const QString &filename)
+{
+  ObjArena::CurrentScope arenaScope(&arena_);
+
+  QFile file(filename);
+
+  if (! file.open(QIODevice::ReadOnly))
+    return false;
+
+  qint64 size = file.size();
+
+  const uchar *data = (size >= qint64(sizeof(NetlistHeader)) ? file.map(0, size) : nullptr);
+
+  if (! data)
+    return false;
+
+  //---
+
+  // validate all sections before creating anything so bad file adds nothing
+  const auto *header = reinterpret_cast<const NetlistHeader *>(data);
+
+  if (header->magic != netlistMagic || header->version != netlistVersion ||
+      header->size != uint32_t(size))
+    return false;
+
+  static const size_t sectionSizes[NETLIST_NUM_SECTIONS] = {
+    sizeof(int32_t), 1, sizeof(int32_t), sizeof(NetlistGate), sizeof(int32_t),
+    sizeof(int32_t), sizeof(NetlistBus), sizeof(int32_t), sizeof(NetlistGroup),
+    sizeof(NetlistGroupGate), sizeof(int32_t), sizeof(int32_t)
+  };
+
+  for (int i = 0; i < NETLIST_NUM_SECTIONS; ++i) {
+    if (header->offset[i] % 4 ||
+        uint64_t(header->offset[i]) + header->count[i]*sectionSizes[i] > uint64_t(size))
+      return false;
+  }
+
+  auto section = [&](NetlistSection section) {
+    return reinterpret_cast<const int32_t *>(data + header->offset[section]);
+  };
+
+  const int32_t *strings    = section(NETLIST_STRINGS);
+  const char    *chars      = reinterpret_cast<const char *>(data + header->offset[NETLIST_CHARS]);
+  const int32_t *types      = section(NETLIST_TYPES);
+  const auto    *gates      = reinterpret_cast<const NetlistGate *>(section(NETLIST_GATES));
+  const int32_t *portNets   = section(NETLIST_PORT_NETS);
+  const int32_t *conns      = section(NETLIST_CONNECTIONS);
+  const auto    *buses      = reinterpret_cast<const NetlistBus *>(section(NETLIST_BUSES));
+  const int32_t *busNets    = section(NETLIST_BUS_NETS);
+  const auto    *groups     = reinterpret_cast<const NetlistGroup *>(section(NETLIST_GROUPS));
+  const auto    *groupGates =
+    reinterpret_cast<const NetlistGroupGate *>(section(NETLIST_GROUP_GATES));
+  const int32_t *groupNets  = section(NETLIST_GROUP_NETS);
+  const int32_t *groupBuses = section(NETLIST_GROUP_BUSES);
+
+  auto ns  = int(header->count[NETLIST_STRINGS    ]);
+  auto nch = int(header->count[NETLIST_CHARS      ]);
+  auto nt  = int(header->count[NETLIST_TYPES      ]);
+  auto ng  = int(header->count[NETLIST_GATES      ]);
+  auto npn = int(header->count[NETLIST_PORT_NETS  ]);
+  auto nc  = int(header->count[NETLIST_CONNECTIONS]);
+  auto nb  = int(header->count[NETLIST_BUSES      ]);
+  auto nbn = int(header->count[NETLIST_BUS_NETS   ]);
+  auto npg = int(header->count[NETLIST_GROUPS     ]);
+  auto ngg = int(header->count[NETLIST_GROUP_GATES]);
+  auto ngn = int(header->count[NETLIST_GROUP_NETS ]);
+  auto ngb = int(header->count[NETLIST_GROUP_BUSES]);
+
+  auto inRange = [](int i, int n) { return (i >= 0 && i < n); };
+
+  auto rangeValid = [](int start, int num, int n) {
+    return (start >= 0 && num >= 0 && int64_t(start) + num <= n);
+  };
+
+  if (ns == 0 || nch == 0 || chars[nch - 1] != '\0')
+    return false;
+
+  for (int i = 0; i < ns; ++i)
+    if (! inRange(strings[i], nch)) return false;
+
+  auto typeInds = std::vector<int>(uint(nt));
+
+  for (int i = 0; i < nt; ++i) {
+    if (! inRange(types[i], ns)) return false;
+
+    typeInds[uint(i)] = gateTypeIndex(QString::fromUtf8(chars + strings[types[i]]));
+
+    if (typeInds[uint(i)] < 0) return false;
+  }
+
+  for (int i = 0; i < ng; ++i) {
+    const NetlistGate &g = gates[i];
+
+    if (! inRange(g.type, nt) || ! inRange(g.name, ns) || ! inRange(g.orient, 4) ||
+        ! rangeValid(g.portStart, g.numPorts, npn))
+      return false;
+
+    // type parameters (e.g. ram array size) must be valid before gate is created
+    if (! gateTypes()[uint(typeInds[uint(g.type)])].isValid(g.p1, g.p2))
+      return false;
+  }
+
+  for (int i = 0; i < npn; ++i)
+    if (portNets[i] != -1 && ! inRange(portNets[i], nc)) return false;
+
+  for (int i = 0; i < nc; ++i)
+    if (! inRange(conns[i], ns)) return false;
+
+  for (int i = 0; i < nb; ++i) {
+    const NetlistBus &b = buses[i];
+
+    if (! inRange(b.name, ns) || b.n <= 0 || (b.gate != -1 && ! inRange(b.gate, ng)) ||
+        ! inRange(b.position, 3) || ! rangeValid(b.netStart, b.n, nbn))
+      return false;
+  }
+
+  for (int i = 0; i < nbn; ++i)
+    if (busNets[i] != -1 && ! inRange(busNets[i], nc)) return false;
+
+  if (npg == 0 || groups[0].parent != -1)
+    return false;
+
+  auto isGrid = [](const NetlistGroup &g) {
+    return (static_cast<PlacementGroup::Placement>(g.placement) ==
+            PlacementGroup::Placement::GRID);
+  };
+
+  // grid cells [pos, pos + n) inside grid size (no overflow for any values)
+  auto cellsValid = [](int32_t pos, int32_t n, int32_t size) {
+    return (n > 0 && pos >= 0 && pos <= size - n);
+  };
+
+  for (int i = 0; i < npg; ++i) {
+    const NetlistGroup &g = groups[i];
+
+    if ((i > 0 && ! inRange(g.parent, i)) || ! inRange(g.placement, 3) ||
+        ! inRange(g.alignment, 6) || ! inRange(g.expandName, ns) ||
+        ! inRange(g.collapseName, ns) || ! rangeValid(g.gateStart, g.numGates, ngg) ||
+        ! rangeValid(g.netStart, g.numNets, ngn) || ! rangeValid(g.busStart, g.numBuses, ngb))
+      return false;
+
+    // grid size (unused, usually -1, for other placements)
+    int minSize = (isGrid(g) ? 1 : -1);
+
+    if (g.nr < minSize || g.nr > PlacementGroup::maxGridSize ||
+        g.nc < minSize || g.nc > PlacementGroup::maxGridSize)
+      return false;
+
+    // position in parent grid
+    if (i > 0 && isGrid(groups[g.parent])) {
+      const NetlistGroup &pg = groups[g.parent];
+
+      if (! cellsValid(g.r, g.pnr, pg.nr) || ! cellsValid(g.c, g.pnc, pg.nc))
+        return false;
+    }
+
+    if (isGrid(g)) {
+      for (int j = 0; j < g.numGates; ++j) {
+        const NetlistGroupGate &gg = groupGates[g.gateStart + j];
+
+        if (! cellsValid(gg.r, gg.nr, g.nr) || ! cellsValid(gg.c, gg.nc, g.nc))
+          return false;
+      }
+    }
+  }
+
+  for (int i = 0; i < ngg; ++i) {
+    const NetlistGroupGate &gg = groupGates[i];
+
+    if (! inRange(gg.gate, ng) || ! inRange(gg.alignment, 6) ||
+        gg.nr <= 0 || gg.nr > PlacementGroup::maxGridSize ||
+        gg.nc <= 0 || gg.nc > PlacementGroup::maxGridSize)
+      return false;
+  }
+
+  for (int i = 0; i < ngn; ++i)
+    if (! inRange(groupNets[i], nc)) return false;
+
+  for (int i = 0; i < ngb; ++i)
+    if (! inRange(groupBuses[i], nb)) return false;
+
+  //---
+
+  auto string = [&](int i) { return QString::fromUtf8(chars + strings[i]); };
+
+  // create gates (ports must match type)
+  auto newGates = std::vector<Gate *>(uint(ng));
+
+  for (int i = 0; i < ng; ++i) {
+    const NetlistGate &g = gates[i];
+
+    const GateType &type = gateTypes()[uint(typeInds[uint(g.type)])];
+
+    Gate *gate = type.create(string(g.name), g.p1, g.p2);
+
+    if (int(gate->inputs().size() + gate->outputs().size()) != g.numPorts) {
+      delete gate;
+
+      for (int j = 0; j < i; ++j)
+        delete newGates[uint(j)];
+
+      return false;
+    }
+
+    gate->setSchem(this);
+
+    gate->setOrientation(static_cast<Gate::Orientation>(g.orient));
+    gate->setFlipped    (g.flipped);
+
+    newGates[uint(i)] = gate;
+  }
+
+  // add gates directly (placed in groups below)
+  simValid_ = false;
+
+  for (auto &gate : newGates) {
+    gate->setSchemInd(int(gates_.size()));
+
+    gates_.push_back(gate);
+  }
+
+  //---
+
+  auto newConnections = std::vector<Connection *>(uint(nc));
+
+  for (int i = 0; i < nc; ++i)
+    newConnections[uint(i)] = addConnection(string(conns[i]));
+
+  for (int i = 0; i < ng; ++i) {
+    const NetlistGate &g = gates[i];
+
+    for (int j = 0; j < g.numPorts; ++j) {
+      int net = portNets[g.portStart + j];
+
+      if (net >= 0)
+        newGates[uint(i)]->connect(j, newConnections[uint(net)]);
+    }
+  }
+
+  //---
+
+  auto newBuses = std::vector<Bus *>(uint(nb));
+
+  for (int i = 0; i < nb; ++i) {
+    const NetlistBus &b = buses[i];
+
+    Bus *bus = addBus(string(b.name), b.n);
+
+    for (int j = 0; j < b.n; ++j) {
+      int net = busNets[b.netStart + j];
+
+      if (net >= 0)
+        bus->addConnection(newConnections[uint(net)], j);
+    }
+
+    if (b.gate >= 0)
+      bus->setGate(newGates[uint(b.gate)]);
+
+    bus->setFlipped (b.flipped);
+    bus->setPosition(static_cast<Bus::Position>(b.position), double(b.offset));
+
+    newBuses[uint(i)] = bus;
+  }
+
+  //---
+
+  // root group contents are added to current placement group
+  auto newGroups = std::vector<PlacementGroup *>(uint(npg));
+
+  for (int i = 0; i < npg; ++i) {
+    const NetlistGroup &g = groups[i];
+
+    PlacementGroup *placementGroup = placementGroup_;
+
+    if (i > 0) {
+      placementGroup =
+        new PlacementGroup(static_cast<PlacementGroup::Placement>(g.placement), g.nr, g.nc);
+
+      newGroups[uint(g.parent)]->addPlacementGroup(placementGroup, g.r, g.c, g.pnr, g.pnc,
+                                                   static_cast<Alignment>(g.alignment));
+
+      placementGroup->setExpandName  (string(g.expandName));
+      placementGroup->setCollapseName(string(g.collapseName));
+
+      if (g.indexRow >= 0)
+        placementGroup->setIndexName(g.indexRow, g.indexCol);
+    }
+
+    for (int j = 0; j < g.numGates; ++j) {
+      const NetlistGroupGate &gg = groupGates[g.gateStart + j];
+
+      placementGroup->addGate(newGates[uint(gg.gate)], gg.r, gg.c, gg.nr, gg.nc,
+                              static_cast<Alignment>(gg.alignment));
+    }
+
+    for (int j = 0; j < g.numNets; ++j)
+      placementGroup->addConnection(newConnections[uint(groupNets[g.netStart + j])]);
+
+    for (int j = 0; j < g.numBuses; ++j)
+      placementGroup->addBus(newBuses[uint(groupBuses[g.busStart + j])]);
+
+    newGroups[uint(i)] = placementGroup;
+  }
+
+  return true;
+}
+
+//---
+
+// text netlist format (one statement per line, '#' starts comment, names are utf8 with
+// space, '=', '#', '%' and control characters encoded as %XX):
+//   group <vertical|horizontal|grid> [<rows> <columns>] [r=<r> c=<c> nr=<n> nc=<n>
+//         align=<align> expand=<name> collapse=<name> index=<r>,<c>]
+//   end
+//   net <id> [name=<name>]
+//   gate <type> <name> [p1=<n> p2=<n> r=<r> c=<c> nr=<n> nc=<n> align=<align>
+//        orient=<r0|r90|r180|r270> flip=<0|1> exec=<n>] [.<port>=<net> ...]
+//   bus <name> <net> ... [pos=<start|middle|end> offset=<x> flip=<0|1> gate=<n>]
+//
+// Nets are scoped to the enclosing group. A net reference resolves to the innermost
+// declaration and an undeclared net is declared in the current group. Scope tables are
+// dropped at the end of the group so parser memory is bounded by nesting depth.
+// Gates and nets are created in file order (placement tree order). Gate exec order is
+// given by exec=<n> (gates are sorted by it after import, gates without it keep file
+// order after those with it). A bus gate=<n> anchors the bus to the gate with exec=<n>
+// (resolved after all gates are read). An import error removes everything it created.
+
+static const char *netlistPlacementNames[] = { "vertical", "horizontal", "grid" };
+static const char *netlistAlignNames    [] = { "left", "center", "right",
+                                               "hfill", "vfill", "fill" };
+static const char *netlistOrientNames   [] = { "r0", "r90", "r180", "r270" };
+static const char *netlistPositionNames [] = { "start", "middle", "end" };
+
+static int
+netlistNameIndex(const char **names, int n, const char *name)
+{
+  for (int i = 0; i < n; ++i) {
+    if (strcmp(names[i], name) == 0)
+      return i;
+  }
+
+  return -1;
+}
+
+static QByteArray
+encodeNetlistName(const QString &name)
+{
+  QByteArray ba = name.toUtf8();
+
+  if (ba.isEmpty())
+    return "%00";
+
+  QByteArray str;
+
+  for (int i = 0; i < ba.size(); ++i) {
+    auto c = uchar(ba[i]);
+
+    if (c <= ' ' || c == '=' || c == '#' || c == '%' || c == 127) {
+      static const char *hex = "0123456789ABCDEF";
+
+      str.append('%'); str.append(hex[c >> 4]); str.append(hex[c & 0xF]);
+    }
+    else
+      str.append(char(c));
+  }
+
+  return str;
+}
+
+static QString
+decodeNetlistName(const char *str)
+{
+  if (! strchr(str, '%'))
+    return QString::fromUtf8(str);
+
+  auto hexValue = [](char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return 0;
+  };
+
+  QByteArray ba;
+
+  for (const char *p = str; *p; ++p) {
+    if (p[0] == '%' && p[1] && p[2]) {
+      char c = char((hexValue(p[1]) << 4) | hexValue(p[2]));
+
+      if (c != '\0')
+        ba.append(c);
+
+      p += 2;
+    }
+    else
+      ba.append(*p);
+  }
+
+  return QString::fromUtf8(ba.constData());
+}
+
+bool
+Schematic::
+exportNetlist(const QString &filename)
+{
+  compactObjs();
+
+  QFile file(filename);
+
+  if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
+
+  //---
+
+  // declare each net in lowest group containing its owner, gates and buses so all
+  // references are in scope
+  std::map<const PlacementGroup *, int> depths;
+
+  std::function<void (const PlacementGroup *, int)> addDepth =
+    [&](const PlacementGroup *placementGroup, int depth) {
+    depths[placementGroup] = depth;
+
+    for (const auto &placementGroupData : placementGroup->placementGroups())
+      addDepth(placementGroupData.placementGroup, depth + 1);
+  };
+
+  addDepth(placementGroup_, 0);
+
+  auto commonGroup = [&](const PlacementGroup *g1, const PlacementGroup *g2) {
+    if (! g1) return g2;
+    if (! g2) return g1;
+
+    while (depths[g1] > depths[g2]) g1 = g1->parent();
+    while (depths[g2] > depths[g1]) g2 = g2->parent();
+
+    while (g1 != g2) { g1 = g1->parent(); g2 = g2->parent(); }
+
+    return g1;
+  };
+
+  auto gateGroup = [&](const Gate *gate) -> const PlacementGroup * {
+    return (gate->placementGroup() ? gate->placementGroup() : placementGroup_);
+  };
+
+  auto netGroups = std::vector<const PlacementGroup *>(connections_.size(), nullptr);
+
+  std::function<void (const PlacementGroup *)> addNetGroups =
+    [&](const PlacementGroup *placementGroup) {
+    for (const auto &connection : placementGroup->connections()) {
+      auto &netGroup = netGroups[uint(connection->schemInd())];
+
+      netGroup = commonGroup(netGroup, placementGroup);
+    }
+
+    for (const auto &bus : placementGroup->buses()) {
+      for (int i = 0; i < bus->n(); ++i) {
+        if (! bus->connection(i)) continue;
+
+        auto &netGroup = netGroups[uint(bus->connection(i)->schemInd())];
+
+        netGroup = commonGroup(netGroup, placementGroup);
+      }
+    }
+
+    for (const auto &placementGroupData : placementGroup->placementGroups())
+      addNetGroups(placementGroupData.placementGroup);
+  };
+
+  addNetGroups(placementGroup_);
+
+  for (const auto &connection : connections_) {
+    auto &netGroup = netGroups[uint(connection->schemInd())];
+
+    for (const auto &port : connection->inPorts())
+      netGroup = commonGroup(netGroup, gateGroup(port->gate()));
+
+    for (const auto &port : connection->outPorts())
+      netGroup = commonGroup(netGroup, gateGroup(port->gate()));
+
+    if (! netGroup)
+      netGroup = placementGroup_;
+  }
+
+  std::multimap<const PlacementGroup *, const Connection *> groupNets;
+
+  for (const auto &connection : connections_)
+    groupNets.insert(std::make_pair(netGroups[uint(connection->schemInd())], connection));
+
+  //---
+
+  QByteArray line;
+
+  auto netId = [](const Connection *connection) {
+    return QByteArray("n") + QByteArray::number(connection->schemInd());
+  };
+
+  auto writePos = [&](int r, int c, int nr, int nc, Alignment alignment) {
+    if (r  >= 0) line += " r="  + QByteArray::number(r);
+    if (c  >= 0) line += " c="  + QByteArray::number(c);
+    if (nr != 1) line += " nr=" + QByteArray::number(nr);
+    if (nc != 1) line += " nc=" + QByteArray::number(nc);
+
+    if (alignment != Alignment::CENTER)
+      line += QByteArray(" align=") + netlistAlignNames[int(alignment)];
+  };
+
+  auto writeLine = [&]() {
+    line += '\n';
+
+    file.write(line);
+
+    line.clear();
+  };
+
+  std::function<void (const PlacementGroup *, const PlacementGroup::PlacementGroupData *)>
+   writeGroup = [&](const PlacementGroup *placementGroup,
+                    const PlacementGroup::PlacementGroupData *data) {
+    if (data) {
+      line = QByteArray("group ") + netlistPlacementNames[int(placementGroup->placement())];
+
+      if (placementGroup->placement() == PlacementGroup::Placement::GRID ||
+          placementGroup->numRows() >= 0)
+        line += " " + QByteArray::number(placementGroup->numRows()) +
+                " " + QByteArray::number(placementGroup->numColumns());
+
+      writePos(data->r, data->c, data->nr, data->nc, data->alignment);
+
+      if (placementGroup->expandName() != "")
+        line += " expand=" + encodeNetlistName(placementGroup->expandName());
+
+      if (placementGroup->collapseName() != "")
+        line += " collapse=" + encodeNetlistName(placementGroup->collapseName());
+
+      if (placementGroup->hasIndexName())
+        line += " index=" + QByteArray::number(placementGroup->indexRow()) +
+                "," + QByteArray::number(placementGroup->indexColumn());
+
+      writeLine();
+    }
+
+    auto pn = groupNets.equal_range(placementGroup);
+
+    for (auto p = pn.first; p != pn.second; ++p) {
+      const Connection *connection = (*p).second;
+
+      line = "net " + netId(connection) + " name=" + encodeNetlistName(connection->name());
+
+      writeLine();
+    }
+
+    for (const auto &gateData : placementGroup->gates()) {
+      const Gate *gate = gateData.gate;
+
+      int p1, p2;
+
+      int type = gateTypeIndex(gate, p1, p2);
+
+      if (type < 0)
+        continue;
+
+      line = "gate " + encodeNetlistName(gateTypes()[uint(type)].name) + " " +
+             encodeNetlistName(gate->localName());
+
+      if (p1 != 0) line += " p1=" + QByteArray::number(p1);
+      if (p2 != 0) line += " p2=" + QByteArray::number(p2);
+
+      writePos(gateData.r, gateData.c, gateData.nr, gateData.nc, gateData.alignment);
+
+      if (gate->orientation() != Gate::Orientation::R0)
+        line += QByteArray(" orient=") + netlistOrientNames[int(gate->orientation())];
+
+      if (gate->isFlipped())
+        line += " flip=1";
+
+      // position in exec order (file is in placement tree order)
+      line += " exec=" + QByteArray::number(gate->schemInd());
+
+      int np = int(gate->inputs().size() + gate->outputs().size());
+
+      for (int i = 0; i < np; ++i) {
+        const Port *port = gate->portByIndex(i);
+
+        if (port->connection())
+          line += " ." + encodeNetlistName(port->name()) + "=" + netId(port->connection());
+      }
+
+      writeLine();
+    }
+
+    for (const auto &bus : placementGroup->buses()) {
+      line = "bus " + encodeNetlistName(bus->name());
+
+      for (int i = 0; i < bus->n(); ++i)
+        line += " " + (bus->connection(i) ? netId(bus->connection(i)) : QByteArray("-"));
+
+      if (bus->position() != Bus::Position::MIDDLE)
+        line += QByteArray(" pos=") + netlistPositionNames[int(bus->position())];
+
+      if (bus->offset() != 0.0)
+        line += " offset=" + QByteArray::number(bus->offset());
+
+      if (bus->isFlipped())
+        line += " flip=1";
+
+      // anchor gate by its exec index (only exported gates have one)
+      if (bus->gate()) {
+        int p1, p2;
+
+        if (gateTypeIndex(bus->gate(), p1, p2) >= 0)
+          line += " gate=" + QByteArray::number(bus->gate()->schemInd());
+      }
+
+      writeLine();
+    }
+
+    for (const auto &placementGroupData : placementGroup->placementGroups())
+      writeGroup(placementGroupData.placementGroup, &placementGroupData);
+
+    if (data) {
+      line = "end";
+
+      writeLine();
+    }
+  };
+
+  line = "# CQSchem netlist";
+
+  writeLine();
+
+  writeGroup(placementGroup_, nullptr);
+
+  return true;
+}
+
+bool
+Schematic::
+importNetlist(const QString &filename, bool bench)
+{
+  ObjArena::CurrentScope arenaScope(&arena_);
+
+  QFile file(filename);
+
+  if (! file.open(QIODevice::ReadOnly))
+    return false;
+
+  auto t1 = std::chrono::steady_clock::now();
+
+  //---
+
+  // nets declared in group (dropped at group end)
+  struct Scope {
+    using Nets = QHash<QString, Connection *>;
+
+    PlacementGroup *placementGroup { nullptr };
+    Nets            nets;
+  };
+
+  std::vector<Scope> scopes(1);
+
+  scopes.back().placementGroup = placementGroup_;
+
+  int    lineNum  = 0;
+  qint64 numBytes = 0;
+  int    ng       = 0;
+  int    nc       = 0;
+  int    nb       = 0;
+
+  // exec index of each new gate (-1 if not specified)
+  std::vector<int> execInds;
+
+  // new buses with gate anchor (exec index of gate)
+  std::vector<std::pair<Bus *, int>> busGates;
+
+  //---
+
+  // remove all objects created by import (new groups are children of current group)
+  auto ng0 = gates_      .size();
+  auto nc0 = connections_.size();
+  auto nb0 = buses_      .size();
+
+  PlacementGroup *rootGroup = placementGroup_;
+
+  auto nrg0 = rootGroup->gates          ().size();
+  auto nrc0 = rootGroup->connections    ().size();
+  auto nrb0 = rootGroup->buses          ().size();
+  auto nrp0 = rootGroup->placementGroups().size();
+
+  auto rollback = [&]() {
+    rootGroup->truncate(nrg0, nrc0, nrb0, nrp0);
+
+    for (auto i = buses_.size(); i-- > nb0; )
+      delete buses_[i];
+
+    for (auto i = gates_.size(); i-- > ng0; )
+      delete gates_[i];
+
+    for (auto i = connections_.size(); i-- > nc0; )
+      delete connections_[i];
+
+    buses_      .resize(nb0);
+    gates_      .resize(ng0);
+    connections_.resize(nc0);
+
+    simValid_ = false;
+  };
+
+  auto error = [&](const std::string &msg) {
+    std::cerr << filename.toStdString() << ":" << lineNum << ": " << msg << "\n";
+
+    rollback();
+
+    return false;
+  };
+
+  auto toInt = [](const char *str, int &i) {
+    char *end = nullptr;
+
+    long l = strtol(str, &end, 10);
+
+    if (*str == '\0' || *end != '\0')
+      return false;
+
+    i = int(l);
+
+    return true;
+  };
+
+  auto addNet = [&](const QString &id, const QString &name) {
+    Scope &scope = scopes.back();
+
+    Connection *connection = addConnection(name);
+
+    scope.placementGroup->addConnection(connection);
+
+    scope.nets[id] = connection;
+
+    ++nc;
+
+    return connection;
+  };
+
+  auto findNet = [&](const QString &id) {
+    for (auto i = scopes.size(); i-- > 0; ) {
+      Connection *connection = scopes[i].nets.value(id, nullptr);
+
+      if (connection)
+        return connection;
+    }
+
+    return addNet(id, id);
+  };
+
+  // check position of child in current group
+  auto checkPos = [&](int r, int c, int nr, int nc) {
+    PlacementGroup *placementGroup = scopes.back().placementGroup;
+
+    if (placementGroup->placement() != PlacementGroup::Placement::GRID)
+      return true;
+
+    return (r >= 0 && r + nr <= placementGroup->numRows() &&
+            c >= 0 && c + nc <= placementGroup->numColumns() && nr > 0 && nc > 0);
+  };
+
+  //---
+
+  std::vector<char>   buffer(1 << 20);
+  std::vector<char *> tokens;
+
+  for (;;) {
+    qint64 len = file.readLine(buffer.data(), qint64(buffer.size()));
+
+    if (len < 0)
+      break;
+
+    ++lineNum;
+
+    numBytes += len;
+
+    if (len == qint64(buffer.size()) - 1 && buffer[uint(len - 1)] != '\n')
+      return error("line too long");
+
+    // split line into nul terminated tokens in place
+    tokens.clear();
+
+    for (char *p = buffer.data(); *p && *p != '#'; ) {
+      while (*p && isspace(uchar(*p))) ++p;
+
+      if (! *p || *p == '#') break;
+
+      tokens.push_back(p);
+
+      while (*p && ! isspace(uchar(*p)) && *p != '#') ++p;
+
+      if (*p == '#') { *p = '\0'; break; }
+
+      if (*p) *p++ = '\0';
+    }
+
+    if (tokens.empty())
+      continue;
+
+    auto nt = tokens.size();
+
+    // split key=value option (returns value or nullptr)
+    auto optionValue = [](char *token) {
+      char *p = strchr(token, '=');
+
+      if (! p) return static_cast<char *>(nullptr);
+
+      *p = '\0';
+
+      return p + 1;
+    };
+
+    const char *cmd = tokens[0];
+
+    //---
+
+    if      (strcmp(cmd, "group") == 0) {
+      if (nt < 2)
+        return error("missing group placement");
+
+      int placement = netlistNameIndex(netlistPlacementNames, 3, tokens[1]);
+
+      if (placement < 0)
+        return error("invalid group placement");
+
+      uint i = 2;
+
+      int nr = -1, nc = -1;
+
+      if (i + 1 < nt && toInt(tokens[i], nr)) {
+        if (! toInt(tokens[i + 1], nc))
+          return error("invalid group columns");
+
+        i += 2;
+      }
+
+      if (placement == int(PlacementGroup::Placement::GRID) && (nr <= 0 || nc <= 0))
+        return error("missing grid rows and columns");
+
+      int r = -1, c = -1, pnr = 1, pnc = 1, ir = -1, ic = -1;
+
+      Alignment alignment = Alignment::CENTER;
+
+      QString expandName, collapseName;
+
+      for ( ; i < nt; ++i) {
+        char *value = optionValue(tokens[i]);
+
+        if (! value)
+          return error("invalid group option");
+
+        const char *key = tokens[i];
+
+        bool rc = true;
+
+        if      (strcmp(key, "r" ) == 0) rc = toInt(value, r);
+        else if (strcmp(key, "c" ) == 0) rc = toInt(value, c);
+        else if (strcmp(key, "nr") == 0) rc = toInt(value, pnr);
+        else if (strcmp(key, "nc") == 0) rc = toInt(value, pnc);
+        else if (strcmp(key, "align") == 0) {
+          int ind = netlistNameIndex(netlistAlignNames, 6, value);
+
+          rc = (ind >= 0);
+
+          if (rc) alignment = static_cast<Alignment>(ind);
+        }
+        else if (strcmp(key, "expand"  ) == 0) expandName   = decodeNetlistName(value);
+        else if (strcmp(key, "collapse") == 0) collapseName = decodeNetlistName(value);
+        else if (strcmp(key, "index"   ) == 0) {
+          char *value1 = strchr(value, ',');
+
+          rc = (value1 != nullptr);
+
+          if (rc) {
+            *value1++ = '\0';
+
+            rc = (toInt(value, ir) && toInt(value1, ic) && ir >= 0 && ic >= 0);
+          }
+        }
+        else
+          rc = false;
+
+        if (! rc)
+          return error("invalid group option '" + std::string(key) + "'");
+      }
+
+      if (! checkPos(r, c, pnr, pnc))
+        return error("invalid group position");
+
+      PlacementGroup *placementGroup =
+        scopes.back().placementGroup->addPlacementGroup(
+          static_cast<PlacementGroup::Placement>(placement), nr, nc, r, c, pnr, pnc, alignment);
+
+      placementGroup->setExpandName  (expandName);
+      placementGroup->setCollapseName(collapseName);
+
+      if (ir >= 0)
+        placementGroup->setIndexName(ir, ic);
+
+      scopes.emplace_back();
+
+      scopes.back().placementGroup = placementGroup;
+    }
+    else if (strcmp(cmd, "end") == 0) {
+      if (scopes.size() == 1)
+        return error("unmatched end");
+
+      scopes.pop_back();
+    }
+    else if (strcmp(cmd, "net") == 0) {
+      if (nt < 2)
+        return error("missing net id");
+
+      QString id   = decodeNetlistName(tokens[1]);
+      QString name = id;
+
+      for (uint i = 2; i < nt; ++i) {
+        char *value = optionValue(tokens[i]);
+
+        if (! value || strcmp(tokens[i], "name") != 0)
+          return error("invalid net option");
+
+        name = decodeNetlistName(value);
+      }
+
+      if (scopes.back().nets.contains(id))
+        return error("duplicate net '" + id.toStdString() + "'");
+
+      (void) addNet(id, name);
+    }
+    else if (strcmp(cmd, "gate") == 0) {
+      if (nt < 3)
+        return error("missing gate type or name");
+
+      int type = gateTypeIndex(decodeNetlistName(tokens[1]));
+
+      if (type < 0)
+        return error("invalid gate type '" + std::string(tokens[1]) + "'");
+
+      // options before ports
+      int p1 = 0, p2 = 0, r = -1, c = -1, nr = 1, nc = 1, orient = 0, flip = 0, execInd = -1;
+
+      Alignment alignment = Alignment::CENTER;
+
+      uint i = 3;
+
+      for ( ; i < nt && tokens[i][0] != '.'; ++i) {
+        char *value = optionValue(tokens[i]);
+
+        if (! value)
+          return error("invalid gate option");
+
+        const char *key = tokens[i];
+
+        bool rc = true;
+
+        if      (strcmp(key, "p1"  ) == 0) rc = toInt(value, p1);
+        else if (strcmp(key, "p2"  ) == 0) rc = toInt(value, p2);
+        else if (strcmp(key, "r"   ) == 0) rc = toInt(value, r);
+        else if (strcmp(key, "c"   ) == 0) rc = toInt(value, c);
+        else if (strcmp(key, "nr"  ) == 0) rc = toInt(value, nr);
+        else if (strcmp(key, "nc"  ) == 0) rc = toInt(value, nc);
+        else if (strcmp(key, "flip") == 0) rc = toInt(value, flip);
+        else if (strcmp(key, "exec") == 0) rc = (toInt(value, execInd) && execInd >= 0);
+        else if (strcmp(key, "orient") == 0) {
+          orient = netlistNameIndex(netlistOrientNames, 4, value);
+
+          rc = (orient >= 0);
+        }
+        else if (strcmp(key, "align") == 0) {
+          int ind = netlistNameIndex(netlistAlignNames, 6, value);
+
+          rc = (ind >= 0);
+
+          if (rc) alignment = static_cast<Alignment>(ind);
+        }
+        else
+          rc = false;
+
+        if (! rc)
+          return error("invalid gate option '" + std::string(key) + "'");
+      }
+
+      if (! checkPos(r, c, nr, nc))
+        return error("invalid gate position");
+
+      if (! gateTypes()[uint(type)].isValid(p1, p2))
+        return error("invalid gate parameters");
+
+      Gate *gate = gateTypes()[uint(type)].create(decodeNetlistName(tokens[2]), p1, p2);
+
+      gate->setSchem(this);
+
+      gate->setOrientation(static_cast<Gate::Orientation>(orient));
+      gate->setFlipped    (flip);
+
+      gate->setSchemInd(int(gates_.size()));
+
+      gates_.push_back(gate);
+
+      simValid_ = false;
+
+      scopes.back().placementGroup->addGate(gate, r, c, nr, nc, alignment);
+
+      execInds.push_back(execInd);
+
+      ++ng;
+
+      //---
+
+      // ports
+      for ( ; i < nt; ++i) {
+        char *value = optionValue(tokens[i]);
+
+        if (tokens[i][0] != '.' || ! value)
+          return error("invalid gate port");
+
+        int ind = gate->portIndex(decodeNetlistName(tokens[i] + 1));
+
+        if (ind < 0)
+          return error("invalid gate port '" + std::string(tokens[i] + 1) + "'");
+
+        if (gate->portByIndex(ind)->connection())
+          return error("duplicate gate port '" + std::string(tokens[i] + 1) + "'");
+
+        gate->connect(ind, findNet(decodeNetlistName(value)));
+      }
+    }
+    else if (strcmp(cmd, "bus") == 0) {
+      if (nt < 2)
+        return error("missing bus name");
+
+      std::vector<const char *> nets;
+
+      int    position = int(Bus::Position::MIDDLE);
+      double offset   = 0.0;
+      int    flip     = 0;
+      int    gateInd  = -1;
+
+      for (uint i = 2; i < nt; ++i) {
+        char *value = optionValue(tokens[i]);
+
+        if (! value) {
+          nets.push_back(tokens[i]);
+          continue;
+        }
+
+        const char *key = tokens[i];
+
+        bool rc = true;
+
+        if      (strcmp(key, "pos") == 0) {
+          position = netlistNameIndex(netlistPositionNames, 3, value);
+
+          rc = (position >= 0);
+        }
+        else if (strcmp(key, "offset") == 0) {
+          char *end = nullptr;
+
+          offset = strtod(value, &end);
+
+          rc = (*value != '\0' && *end == '\0');
+        }
+        else if (strcmp(key, "flip") == 0)
+          rc = toInt(value, flip);
+        else if (strcmp(key, "gate") == 0)
+          rc = (toInt(value, gateInd) && gateInd >= 0);
+        else
+          rc = false;
+
+        if (! rc)
+          return error("invalid bus option '" + std::string(key) + "'");
+      }
+
+      if (nets.empty())
+        return error("missing bus nets");
+
+      Bus *bus = addBus(decodeNetlistName(tokens[1]), int(nets.size()));
+
+      for (uint i = 0; i < nets.size(); ++i) {
+        if (strcmp(nets[i], "-") != 0)
+          bus->addConnection(findNet(decodeNetlistName(nets[i])), int(i));
+      }
+
+      bus->setPosition(static_cast<Bus::Position>(position), offset);
+      bus->setFlipped (flip);
+
+      scopes.back().placementGroup->addBus(bus);
+
+      if (gateInd >= 0)
+        busGates.push_back(std::make_pair(bus, gateInd));
+
+      ++nb;
+    }
+    else
+      return error("invalid statement '" + std::string(cmd) + "'");
+  }
+
+  if (scopes.size() != 1)
+    return error("missing end");
+
+  //---
+
+  // resolve bus gate anchors from exec indices
+  if (! busGates.empty()) {
+    std::map<int, Gate *> execGate;
+
+    for (uint i = 0; i < execInds.size(); ++i) {
+      if (execInds[i] < 0)
+        continue;
+
+      if (! execGate.insert(std::make_pair(execInds[i], gates_[ng0 + i])).second)
+        return error("duplicate gate exec index " + std::to_string(execInds[i]));
+    }
+
+    for (const auto &busGate : busGates) {
+      auto p = execGate.find(busGate.second);
+
+      if (p == execGate.end())
+        return error("invalid bus gate " + std::to_string(busGate.second));
+
+      busGate.first->setGate((*p).second);
+    }
+  }
+
+  //---
+
+  // restore exec order of new gates
+  if (std::any_of(execInds.begin(), execInds.end(), [](int i) { return i >= 0; })) {
+    using ExecGate = std::pair<int, Gate *>;
+
+    std::vector<ExecGate> execGates;
+
+    for (uint i = 0; i < execInds.size(); ++i) {
+      int execInd = (execInds[i] >= 0 ? execInds[i] : std::numeric_limits<int>::max());
+
+      execGates.push_back(ExecGate(execInd, gates_[ng0 + i]));
+    }
+
+    std::stable_sort(execGates.begin(), execGates.end(),
+      [](const ExecGate &g1, const ExecGate &g2) { return g1.first < g2.first; });
+
+    for (uint i = 0; i < execGates.size(); ++i) {
+      Gate *gate = execGates[i].second;
+
+      gate->setSchemInd(int(ng0 + i));
+
+      gates_[ng0 + i] = gate;
+    }
+  }
+
+  //---
+
+  if (bench) {
+    auto t2 = std::chrono::steady_clock::now();
+
+    double ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    double s  = std::max(ms/1000.0, 1E-9);
+
+    std::cerr << "Imported " << lineNum << " lines (" << numBytes << " bytes), " <<
+                 ng << " gates, " << nc << " nets, " << nb << " buses in " << ms << "ms (" <<
+                 lineNum/s << " lines/s, " << ng/s << " gates/s, " <<
+                 numBytes/(1024.0*1024.0)/s << " MB/s)\n";
+  }
+
+  return true;
+}
+
+bool
+Schematic::
+netlistCheck()
+{
+  // export netlist, import into new schematic and compare outputs of both for same
+  // input sequence (checks round trip keeps connectivity and exec order)
+  QString filename = QDir::tempPath() + "/CQSchem_check.netlist";
+
+  if (! exportNetlist(filename)) {
+    std::cerr << "Failed to export netlist '" << filename.toStdString() << "'\n";
+    return false;
+  }
+
+  // new schematic makes its arena current so restore ours when done
+  ObjArena::CurrentScope arenaScope(&arena_);
+
+  Schematic schem(nullptr);
+
+  bool rc = schem.importNetlist(filename);
+
+  QFile::remove(filename);
+
+  if (! rc)
+    return false;
+
+  //---
+
+  // inputs and outputs matched by name
+  auto ioConnections = [](const Schematic &schem, Connections &in, Connections &out) {
+    for (const auto &connection : schem.connections_) {
+      if (! connection) continue;
+
+      if      (connection->isInput())
+        in.push_back(connection);
+      else if (connection->isOutput())
+        out.push_back(connection);
+    }
+
+    auto cmpName = [](const Connection *c1, const Connection *c2) {
+      return (c1->name() < c2->name()); };
+
+    std::stable_sort(in .begin(), in .end(), cmpName);
+    std::stable_sort(out.begin(), out.end(), cmpName);
+  };
+
+  Connections in1, out1, in2, out2;
+
+  ioConnections(*this, in1, out1);
+  ioConnections(schem, in2, out2);
+
+  auto sameNames = [](const Connections &c1, const Connections &c2) {
+    if (c1.size() != c2.size())
+      return false;
+
+    for (uint i = 0; i < c1.size(); ++i) {
+      if (c1[i]->name() != c2[i]->name())
+        return false;
+    }
+
+    return true;
+  };
+
+  if (! sameNames(in1, in2) || ! sameNames(out1, out2)) {
+    std::cerr << "Netlist check: inputs or outputs differ after import\n";
+    return false;
+  }
+
+  //---
+
+  // all input combinations (fixed pseudo random sequence if too many inputs)
+  auto ni = in1 .size();
+  auto no = out1.size();
+
+  uint n = (ni <= 12 ? (1U << ni) : 4096);
+
+  uint32_t seed = 1;
+
+  auto nextBit = [&]() {
+    seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5;
+
+    return bool(seed & 1);
+  };
+
+  int numDiffs = 0;
+
+  for (uint i = 0; i < n; ++i) {
+    for (uint j = 0; j < ni; ++j) {
+      bool b = (ni <= 12 ? bool(i & (1U << j)) : nextBit());
+
+      in1[j]->setValue(b);
+      in2[j]->setValue(b);
+    }
+
+    exec();
+
+    schem.exec();
+
+    for (uint j = 0; j < no; ++j) {
+      if (out1[j]->getValue() == out2[j]->getValue())
+        continue;
+
+      if (numDiffs < 10)
+        std::cerr << "Netlist check: step " << i << " output '" <<
+                     out1[j]->name().toStdString() << "' differs\n";
+
+      ++numDiffs;
+    }
+  }
+
+  std::cerr << "Netlist check: " << gates_.size() << " gates, " << ni << " inputs, " <<
+               no << " outputs, " << n << " steps, " << numDiffs << " differences\n";
+
+  return (numDiffs == 0);
+}
+
+void
+Schematic::
+moveGate(Gate *gate, const QPointF &d)
+{
+  QRectF rect = gate->rect().translated(d.x(), d.y());
+
+  // if full redraw pending or gate moved outside bounds then update all
+  if (changed_ || image_.isNull() || ! rect_.contains(rect)) {
+    gate->setRect(rect);
+
+    calcBounds();
+
+    redraw();
+
+    return;
+  }
+
+  //---
+
+  // pixel transform is unchanged so move gate pixel rect and ports by pixel delta
+  QPointF pd = renderer_.windowToPixel(d) - renderer_.windowToPixel(QPointF(0.0, 0.0));
+
+  Gate::Connections connections;
+
+  gate->connections(connections);
+
+  // add old area of gate and connected lines
+  QRectF drect = gate->prect();
+
+  for (auto &connection : connections) {
+    if (connection->isLinesValid())
+      drect = drect.united(connection->linesRect());
+  }
+
+  gate->setRect(rect);
+
+  gate->translatePixelRect(pd.x(), pd.y());
+
+  // reroute connected lines and add new area
+  drect = drect.united(gate->prect());
+
+  renderer_.schem = this;
+
+  for (auto &connection : connections) {
+    if (! connection->bus())
+      connection->invalidateLines();
+  }
+
+  routeConnections();
+
+  for (auto &connection : connections) {
+    if (! connection->bus())
+      drect = drect.united(connection->linesRect());
+  }
+
+  // add margin for pen, port and connection text
+  double m = 64;
+
+  drect.adjust(-m, -m, m, m);
+
+  dirtyRect_ = (dirtyRect_.isValid() ? dirtyRect_.united(drect) : drect);
+
+  update(dirtyRect_.toAlignedRect());
+}
+
+void
+Schematic::
+selectedGates(Gates &gates) const
+{
+  for (auto &gate : gates_) {
+    if (gate->isSelected())
+      gates.push_back(gate);
+  }
+}
+
+void
+Schematic::
 selectedConnections(Connections &connections) const
 {
-  for (auto &connection : connections_) {
-    if (connection->isSelected())
-      connections.push_back(connection);
+  for (auto &connection : connections_) {
+    if (connection->isSelected())
+      connections.push_back(connection);
+  }
+}
+
+void
+Schematic::
+selectedBuses(Buses &buses) const
+{
+  for (const auto &bus : buses) {
+    if (bus->isSelected())
+      buses.push_back(bus);
+  }
+}
+
+void
+Schematic::
+selectedPlacementGroups(PlacementGroups &placementGroups) const
+{
+  for (auto &placementGroupData : placementGroup_->placementGroups()) {
+    PlacementGroup *placementGroup = placementGroupData.placementGroup;
+
+    if (placementGroup->isSelected())
+      placementGroups.push_back(placementGroup);
+  }
+}
+
+Gate *
+Schematic::
+nearestGate(const QPointF &p) const
+{
+  for (auto &gate : gates_) {
+    if (gate->inside(p))
+      return gate;
+  }
+
+  return nullptr;
+}
+
+PlacementGroup *
+Schematic::
+nearestPlacementGroup(const QPointF &p) const
+{
+  return placementGroup_->nearestPlacementGroup(p);
+}
+
+Connection *
+Schematic::
+nearestConnection(const QPointF &p) const
+{
+  for (auto &gate : gates_) {
+    for (auto &port : gate->inputs()) {
+      if (port->connection() && port->connection()->inside(p))
+        return port->connection();
+    }
+
+    for (auto &port : gate->outputs()) {
+      if (port->connection() && port->connection()->inside(p))
+        return port->connection();
+    }
+  }
+
+  return nullptr;
+}
+
+void
+Schematic::
+drawConnection(Renderer *renderer, const QPointF &p1, const QPointF &p2)
+{
+  double dx = std::abs(p2.x() - p1.x());
+  double dy = std::abs(p2.y() - p1.y());
+
+  if (dx > dy) {
+    if (dy > 1E-6) {
+      double ym = (p1.y() + p2.y())/2.0;
+
+      Schematic::drawLine(renderer, p1                 , QPointF(p1.x(), ym));
+      Schematic::drawLine(renderer, QPointF(p1.x(), ym), QPointF(p2.x(), ym));
+      Schematic::drawLine(renderer, QPointF(p2.x(), ym), p2                 );
+    }
+    else
+      Schematic::drawLine(renderer, p1, p2);
+  }
+  else {
+    if (dx > 1E-6) {
+      double xm = (p1.x() + p2.x())/2.0;
+
+      Schematic::drawLine(renderer, p1                 , QPointF(xm, p1.y()));
+      Schematic::drawLine(renderer, QPointF(xm, p1.y()), QPointF(xm, p2.y()));
+      Schematic::drawLine(renderer, QPointF(xm, p2.y()), p2                 );
+    }
+    else
+      Schematic::drawLine(renderer, p1, p2);
+  }
+}
+
+void
+Schematic::
+drawTextInRect(Renderer *renderer, const QRectF &r, const QString &text)
+{
+  if (r.height() < 3)
+    return;
+
+  renderer->setFontSize(r.height());
+
+  QPointF c = r.center();
+
+  drawTextAtPoint(renderer, c, text);
+}
+
+void
+Schematic::
+drawTextOnLine(Renderer *renderer, const QPointF &p1, const QPointF &p2,
+               const QString &name, TextLinePos pos)
+{
+  if      (pos == TextLinePos::START) {
+    QPointF pt(std::min(p1.x(), p2.x()) - 4, (p1.y() + p2.y())/2);
+
+    drawTextAtPoint(renderer, pt, name, Schematic::TextAlign::RIGHT);
+  }
+  else if (pos == TextLinePos::END) {
+    QPointF pt(std::max(p1.x(), p2.x()) + 4, (p1.y() + p2.y())/2);
+
+    drawTextAtPoint(renderer, pt, name, Schematic::TextAlign::LEFT);
+  }
+  else {
+    QPointF pt((p1.x() + p2.x())/2, (p1.y() + p2.y())/2);
+
+    drawTextAtPoint(renderer, pt, name);
   }
 }
 
 void
 Schematic::
-selectedBuses(Buses &buses) const
+drawTextAtPoint(Renderer *renderer, const QPointF &p, const QString &text,
+                TextAlign align)
+{
+  double fh = renderer->windowHeightToPixelHeight(0.25);
+  if (fh < 3) return;
+
+  renderer->setFontSize(fh);
+
+  QFontMetricsF fm(renderer->painter->font());
+
+  double dx = fm.horizontalAdvance(text);
+  double dy = (fm.ascent() - fm.descent())/2.0;
+
+  QPointF pm;
+
+  if      (align == TextAlign::CENTER)
+    pm = QPointF(p.x() - dx/2.0, p.y() + dy);
+  else if (align == TextAlign::RIGHT)
+    pm = QPointF(p.x() - dx, p.y() + dy);
+  else
+    pm = QPointF(p.x(), p.y() + dy);
+
+  renderer->painter->drawText(pm, text);
+}
+
+void
+Schematic::
+drawLine(Renderer *renderer, const QPointF &p1, const QPointF &p2)
+{
+  double dx = std::abs(p2.x() - p1.x());
+  double dy = std::abs(p2.y() - p1.y());
+
+  assert(int(dx) <= 1 || int(dy) <= 1);
+
+  renderer->painter->drawLine(p1, p2);
+}
+
+QSize
+Schematic::
+sizeHint() const
+{
+  return QSize(800, 800);
+}
+
+//---
+
+Waveform::
+Waveform(Schematic *schem) :
+ schem_(schem)
+{
+  setFocusPolicy(Qt::StrongFocus);
+
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+
+  setMouseTracking(true);
+
+  schem_->setWaveform(this);
+}
+
+void
+Waveform::
+paintEvent(QPaintEvent *)
+{
+  QPainter painter(this);
+
+  painter.fillRect(rect(), Qt::black);
+
+  //--
+
+  QFontMetrics fm(font());
+
+  int w = 0;
+
+  for (auto &ci : connInds_) {
+    const QString &name = ci.first->name();
+
+    w = std::max(w, fm.horizontalAdvance(name));
+  }
+
+  //--
+
+  int dx = 1;
+  int dy = fm.height();
+
+  int dy1 = dy - 4;
+
+  int x = w + 4;
+  int y = 4;
+
+  for (auto &iv : indValues_) {
+    const Connection *connection = indConns_[iv.first];
+
+    const QString &name = connection->name();
+
+    painter.setPen(Qt::white);
+
+    painter.drawText(2, y + fm.ascent(), name);
+
+    //---
+
+    QPainterPath path;
+
+    int  lastT     = 0;
+    bool lastValue = false;
+
+    path.moveTo(x, y);
+
+    for (auto &tv : iv.second) {
+      int  t     = tv.first;
+      bool value = tv.second;
+
+      if (t == lastT) {
+        path.lineTo(x + dx*t, y + dy1*lastValue);
+        path.lineTo(x + dx*t, y + dy1*value    );
+      }
+      else {
+        path.lineTo(x + dx*lastT, y + dy1*value);
+        path.lineTo(x + dx*t    , y + dy1*value);
+      }
+
+      lastT     = t;
+      lastValue = value;
+    }
+
+    painter.drawPath(path);
+
+    y += 16;
+  }
+}
+
+void
+Waveform::
+addValue(const Connection *connection, int t, bool b)
+{
+  auto p = connInds_.find(connection);
+
+  if (p == connInds_.end()) {
+    p = connInds_.insert(p, ConnInds::value_type(connection, indValues_.size()));
+
+    indConns_[(*p).second] = connection;
+  }
+
+  indValues_[(*p).second][t] = b;
+}
+
+size_t
+Waveform::
+memBytes() const
+{
+  // map nodes (value and tree pointers)
+  static const size_t nodeBytes = 4*sizeof(void *);
+
+  size_t n = (connInds_.size() + indConns_.size() + indValues_.size())*
+             (nodeBytes + 2*sizeof(void *));
+
+  for (const auto &iv : indValues_)
+    n += iv.second.size()*(nodeBytes + sizeof(Values::value_type));
+
+  return n;
+}
+
+QSize
+Waveform::
+sizeHint() const
+{
+  return QSize(100, 800);
+}
+
+//---
+
+StatsPanel::
+StatsPanel(Schematic *schem) :
+ schem_(schem)
+{
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+
+  QFont font("Monospace");
+
+  font.setStyleHint(QFont::TypeWriter);
+
+  setFont(font);
+
+  schem_->setStatsPanel(this);
+}
+
+void
+StatsPanel::
+paintEvent(QPaintEvent *)
+{
+  QPainter painter(this);
+
+  painter.fillRect(rect(), Qt::black);
+
+  painter.setPen(Qt::white);
+
+  QFontMetrics fm(font());
+
+  int y = 4;
+
+  for (const auto &line : schem_->statsLines()) {
+    painter.drawText(4, y + fm.ascent(), line);
+
+    y += fm.height();
+  }
+}
+
+QSize
+StatsPanel::
+sizeHint() const
+{
+  return QSize(100, 200);
+}
+
+//---
+
+MemoryPanel::
+MemoryPanel(Schematic *schem) :
+ schem_(schem)
+{
+  setWindowTitle("Memory Report");
+
+  QFont font("Monospace");
+
+  font.setStyleHint(QFont::TypeWriter);
+
+  setFont(font);
+}
+
+void
+MemoryPanel::
+updateLines()
+{
+  lines_ = schem_->memoryLines();
+
+  resize(sizeHint());
+
+  update();
+}
+
+void
+MemoryPanel::
+paintEvent(QPaintEvent *)
+{
+  QPainter painter(this);
+
+  painter.fillRect(rect(), Qt::black);
+
+  painter.setPen(Qt::white);
+
+  QFontMetrics fm(font());
+
+  int y = 4;
+
+  for (const auto &line : lines_) {
+    painter.drawText(4, y + fm.ascent(), line);
+
+    y += fm.height();
+  }
+}
+
+QSize
+MemoryPanel::
+sizeHint() const
+{
+  QFontMetrics fm(font());
+
+  int w = 0;
+
+  for (const auto &line : lines_)
+    w = std::max(w, fm.horizontalAdvance(line));
+
+  return QSize(w + 8, int(lines_.size())*fm.height() + 8);
+}
+
+//---
+
+const char *
+PaintProfile::
+phaseName(Phase phase)
 {
-  for (const auto &bus : buses) {
-    if (bus->isSelected())
-      buses.push_back(bus);
+  switch (phase) {
+    case Phase::GATES      : return "gates";
+    case Phase::ROUTE      : return "route";
+    case Phase::CONNECTIONS: return "connections";
+    case Phase::BUSES      : return "buses";
+    case Phase::PLACEMENT  : return "placement";
+    case Phase::BLIT       : return "blit";
+    case Phase::OVERLAY    : return "overlay";
+    default                : { assert(false); return ""; }
   }
 }
 
+PaintProfile::Timer::
+~Timer()
+{
+  auto t = Clock::now();
+
+  profile_.addTime(phase_, std::chrono::duration<double, std::milli>(t - t_).count());
+
+  // phase event (per phase not per object to keep trace small)
+  if (Trace::isEnabled())
+    Trace::instance()->addEvent("paint", phaseName(phase_), t_, t);
+}
+
 void
-Schematic::
-selectedPlacementGroups(PlacementGroups &placementGroups) const
+PaintProfile::
+startFrame()
 {
-  for (auto &placementGroupData : placementGroup_->placementGroups()) {
-    PlacementGroup *placementGroup = placementGroupData.placementGroup;
+  if (numFramesDrawn_ > 0)
+    frame_ = (frame_ + 1) % numFrames;
 
-    if (placementGroup->isSelected())
-      placementGroups.push_back(placementGroup);
+  ++numFramesDrawn_;
+
+  for (int i = 0; i < numPhases; ++i) {
+    times_[i][frame_] = 0.0;
+
+    drawn_ [i] = 0;
+    culled_[i] = 0;
   }
 }
 
-Gate *
-Schematic::
-nearestGate(const QPointF &p) const
+double
+PaintProfile::
+avgTime(Phase phase) const
 {
-  for (auto &gate : gates_) {
-    if (gate->inside(p))
-      return gate;
-  }
+  int n = std::min(numFramesDrawn_, numFrames);
 
-  return nullptr;
+  if (n == 0)
+    return 0.0;
+
+  double sum = 0.0;
+
+  for (int i = 0; i < n; ++i)
+    sum += times_[uint(phase)][i];
+
+  return sum/n;
 }
 
-PlacementGroup *
-Schematic::
-nearestPlacementGroup(const QPointF &p) const
+double
+PaintProfile::
+maxTime(Phase phase) const
 {
-  return placementGroup_->nearestPlacementGroup(p);
+  int n = std::min(numFramesDrawn_, numFrames);
+
+  double max = 0.0;
+
+  for (int i = 0; i < n; ++i)
+    max = std::max(max, times_[uint(phase)][i]);
+
+  return max;
 }
 
-Connection *
-Schematic::
-nearestConnection(const QPointF &p) const
+std::vector<QString>
+PaintProfile::
+lines() const
 {
-  for (auto &gate : gates_) {
-    for (auto &port : gate->inputs()) {
-      if (port->connection() && port->connection()->inside(p))
-        return port->connection();
-    }
+  std::vector<QString> lines;
 
-    for (auto &port : gate->outputs()) {
-      if (port->connection() && port->connection()->inside(p))
-        return port->connection();
-    }
+  lines.push_back(QString("%1 %2 %3 %4 %5 %6").
+    arg("Phase", -12).arg("Last(ms)", 9).arg("Avg(ms)", 9).arg("Max(ms)", 9).
+    arg("Drawn", 8).arg("Culled", 8));
+
+  double last = 0.0, avg = 0.0, max = 0.0;
+
+  for (int i = 0; i < numPhases; ++i) {
+    auto phase = Phase(i);
+
+    lines.push_back(QString("%1 %2 %3 %4 %5 %6").
+      arg(phaseName(phase), -12).arg(lastTime(phase), 9, 'f', 3).
+      arg(avgTime(phase), 9, 'f', 3).arg(maxTime(phase), 9, 'f', 3).
+      arg(drawn_[i], 8).arg(culled_[i], 8));
+
+    last += lastTime(phase);
+    avg  += avgTime (phase);
+    max  += maxTime (phase);
   }
 
-  return nullptr;
+  lines.push_back(QString("%1 %2 %3 %4 (%5 frames)").
+    arg("total", -12).arg(last, 9, 'f', 3).arg(avg, 9, 'f', 3).arg(max, 9, 'f', 3).
+    arg(numFramesDrawn_));
+
+  return lines;
 }
 
-void
-Schematic::
-drawConnection(Renderer *renderer, const QPointF &p1, const QPointF &p2)
+bool
+PaintProfile::
+dump(const QString &filename) const
 {
-  double dx = std::abs(p2.x() - p1.x());
-  double dy = std::abs(p2.y() - p1.y());
+  // summary then per frame phase times (oldest first)
+  QFile file(filename);
 
-  if (dx > dy) {
-    if (dy > 1E-6) {
-      double ym = (p1.y() + p2.y())/2.0;
+  if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    return false;
 
-      Schematic::drawLine(renderer, p1                 , QPointF(p1.x(), ym));
-      Schematic::drawLine(renderer, QPointF(p1.x(), ym), QPointF(p2.x(), ym));
-      Schematic::drawLine(renderer, QPointF(p2.x(), ym), p2                 );
-    }
-    else
-      Schematic::drawLine(renderer, p1, p2);
+  QByteArray data;
+
+  for (const auto &line : lines())
+    data += line.toUtf8() + "\n";
+
+  data += "\nframe";
+
+  for (int i = 0; i < numPhases; ++i)
+    data += QByteArray(" ") + phaseName(Phase(i));
+
+  data += "\n";
+
+  int n = std::min(numFramesDrawn_, numFrames);
+
+  for (int j = 0; j < n; ++j) {
+    int frame = (frame_ + numFrames - n + 1 + j) % numFrames;
+
+    data += QByteArray::number(numFramesDrawn_ - n + j);
+
+    for (int i = 0; i < numPhases; ++i)
+      data += " " + QByteArray::number(times_[i][frame]);
+
+    data += "\n";
   }
-  else {
-    if (dx > 1E-6) {
-      double xm = (p1.x() + p2.x())/2.0;
 
-      Schematic::drawLine(renderer, p1                 , QPointF(xm, p1.y()));
-      Schematic::drawLine(renderer, QPointF(xm, p1.y()), QPointF(xm, p2.y()));
-      Schematic::drawLine(renderer, QPointF(xm, p2.y()), p2                 );
-    }
-    else
-      Schematic::drawLine(renderer, p1, p2);
+  return (file.write(data) == data.size());
+}
+
+//---
+
+const char *
+PerfCounters::
+counterName(Counter counter)
+{
+  switch (counter) {
+    case Counter::CYCLES       : return "cycles";
+    case Counter::INSTRUCTIONS : return "instructions";
+    case Counter::L1D_MISSES   : return "l1d_misses";
+    case Counter::LLC_MISSES   : return "llc_misses";
+    case Counter::BRANCH_MISSES: return "branch_misses";
+    default                    : { assert(false); return ""; }
   }
 }
 
-void
-Schematic::
-drawTextInRect(Renderer *renderer, const QRectF &r, const QString &text)
+#ifdef __linux__
+bool
+PerfCounters::
+open()
 {
-  if (r.height() < 3)
-    return;
+  close();
 
-  renderer->setFontSize(r.height());
+  reset();
 
-  QPointF c = r.center();
+  auto openCounter = [&](Counter counter, uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
 
-  drawTextAtPoint(renderer, c, text);
+    memset(&attr, 0, sizeof(attr));
+
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    int leader = fds_[0];
+
+    // leader starts disabled, members follow leader
+    if (leader < 0)
+      attr.disabled = 1;
+
+    int i = int(counter);
+
+    fds_[i] = int(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+
+    if (fds_[i] >= 0 && ioctl(fds_[i], PERF_EVENT_IOC_ID, &ids_[i]) != 0) {
+      ::close(fds_[i]);
+
+      fds_[i] = -1;
+    }
+  };
+
+  openCounter(Counter::CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+
+  if (! isOpen())
+    return false;
+
+  openCounter(Counter::INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  openCounter(Counter::L1D_MISSES  , PERF_TYPE_HW_CACHE,
+              PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+  openCounter(Counter::LLC_MISSES   , PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  openCounter(Counter::BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+  return true;
 }
 
 void
-Schematic::
-drawTextOnLine(Renderer *renderer, const QPointF &p1, const QPointF &p2,
-               const QString &name, TextLinePos pos)
+PerfCounters::
+close()
 {
-  if      (pos == TextLinePos::START) {
-    QPointF pt(std::min(p1.x(), p2.x()) - 4, (p1.y() + p2.y())/2);
+  // close members before leader
+  for (int i = numCounters - 1; i >= 0; --i) {
+    if (fds_[i] >= 0)
+      ::close(fds_[i]);
 
-    drawTextAtPoint(renderer, pt, name, Schematic::TextAlign::RIGHT);
+    fds_[i] = -1;
   }
-  else if (pos == TextLinePos::END) {
-    QPointF pt(std::max(p1.x(), p2.x()) + 4, (p1.y() + p2.y())/2);
+}
 
-    drawTextAtPoint(renderer, pt, name, Schematic::TextAlign::LEFT);
-  }
-  else {
-    QPointF pt((p1.x() + p2.x())/2, (p1.y() + p2.y())/2);
+void
+PerfCounters::
+start()
+{
+  if (! isOpen())
+    return;
 
-    drawTextAtPoint(renderer, pt, name);
-  }
+  ioctl(fds_[0], PERF_EVENT_IOC_RESET , PERF_IOC_FLAG_GROUP);
+  ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
 }
 
 void
-Schematic::
-drawTextAtPoint(Renderer *renderer, const QPointF &p, const QString &text,
-                TextAlign align)
+PerfCounters::
+stop()
 {
-  double fh = renderer->windowHeightToPixelHeight(0.25);
-  if (fh < 3) return;
-
-  renderer->setFontSize(fh);
+  if (! isOpen())
+    return;
 
-  QFontMetricsF fm(renderer->painter->font());
+  ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
 
-  double dx = fm.horizontalAdvance(text);
-  double dy = (fm.ascent() - fm.descent())/2.0;
+  // nr, time enabled, time running then value and id per counter
+  uint64_t data[3 + 2*numCounters];
 
-  QPointF pm;
+  auto n = ::read(fds_[0], data, sizeof(data));
 
-  if      (align == TextAlign::CENTER)
-    pm = QPointF(p.x() - dx/2.0, p.y() + dy);
-  else if (align == TextAlign::RIGHT)
-    pm = QPointF(p.x() - dx, p.y() + dy);
-  else
-    pm = QPointF(p.x(), p.y() + dy);
+  if (n < ssize_t(3*sizeof(uint64_t)))
+    return;
 
-  renderer->painter->drawText(pm, text);
-}
+  uint64_t nr      = std::min(data[0], uint64_t(numCounters));
+  uint64_t enabled = data[1];
+  uint64_t running = data[2];
 
-void
-Schematic::
-drawLine(Renderer *renderer, const QPointF &p1, const QPointF &p2)
-{
-  double dx = std::abs(p2.x() - p1.x());
-  double dy = std::abs(p2.y() - p1.y());
+  // scale if counters were multiplexed
+  double scale = (running > 0 && running < enabled ? double(enabled)/double(running) : 1.0);
 
-  assert(int(dx) <= 1 || int(dy) <= 1);
+  for (uint64_t j = 0; j < nr; ++j) {
+    uint64_t value = data[3 + 2*j];
+    uint64_t id    = data[4 + 2*j];
 
-  renderer->painter->drawLine(p1, p2);
+    for (int i = 0; i < numCounters; ++i) {
+      if (fds_[i] >= 0 && ids_[i] == id) {
+        values_[i] += uint64_t(double(value)*scale);
+        break;
+      }
+    }
+  }
 }
+#else
+bool PerfCounters::open() { return false; }
+void PerfCounters::close() { }
+void PerfCounters::start() { }
+void PerfCounters::stop() { }
+#endif
 
-QSize
-Schematic::
-sizeHint() const
+void
+PerfCounters::
+reset()
 {
-  return QSize(800, 800);
+  for (int i = 0; i < numCounters; ++i)
+    values_[i] = 0;
 }
 
 //---
 
-Waveform::
-Waveform(Schematic *schem) :
- schem_(schem)
+Trace *
+Trace::
+instance()
 {
-  setFocusPolicy(Qt::StrongFocus);
-
-  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
-
-  setMouseTracking(true);
+  static Trace trace;
 
-  schem_->setWaveform(this);
+  return &trace;
 }
 
-void
-Waveform::
-paintEvent(QPaintEvent *)
+Trace::
+Trace()
 {
-  QPainter painter(this);
+  const char *filename = getenv("CQSCHEM_TRACE");
 
-  painter.fillRect(rect(), Qt::black);
+  if (filename && *filename) {
+    enabled_  = true;
+    filename_ = filename;
+    t0_       = Clock::now();
+  }
+}
 
-  //--
+Trace::
+~Trace()
+{
+  if (! enabled_)
+    return;
 
-  QFontMetrics fm(font());
+  if (! write())
+    std::cerr << "Failed to write trace '" << filename_.toStdString() << "'\n";
 
-  int w = 0;
+  if (numDropped_ > 0)
+    std::cerr << "Trace buffer full, " << numDropped_ << " events dropped\n";
+}
 
-  for (auto &ci : connInds_) {
-    const QString &name = ci.first->name();
+void
+Trace::
+addEvent(const char *cat, const char *name,
+         const Clock::time_point &t1, const Clock::time_point &t2)
+{
+  auto *event = newEvent(cat, t1, t2);
 
-    w = std::max(w, fm.horizontalAdvance(name));
-  }
+  if (event)
+    event->name = name;
+}
 
-  //--
+void
+Trace::
+addEvent(const char *cat, const std::string &name,
+         const Clock::time_point &t1, const Clock::time_point &t2)
+{
+  auto *event = newEvent(cat, t1, t2);
 
-  int dx = 1;
-  int dy = fm.height();
+  if (event)
+    event->str = name;
+}
 
-  int dy1 = dy - 4;
+Trace::Event *
+Trace::
+newEvent(const char *cat, const Clock::time_point &t1, const Clock::time_point &t2)
+{
+  if (events_.size() >= maxEvents) {
+    ++numDropped_;
+    return nullptr;
+  }
 
-  int x = w + 4;
-  int y = 4;
+  events_.emplace_back();
 
-  for (auto &iv : indValues_) {
-    const Connection *connection = indConns_[iv.first];
+  auto &event = events_.back();
 
-    const QString &name = connection->name();
+  event.cat = cat;
+  event.ts  = std::chrono::duration<double, std::micro>(t1 - t0_).count();
+  event.dur = std::chrono::duration<double, std::micro>(t2 - t1).count();
 
-    painter.setPen(Qt::white);
+  return &event;
+}
 
-    painter.drawText(2, y + fm.ascent(), name);
+bool
+Trace::
+write() const
+{
+  QFile file(filename_);
 
-    //---
+  if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    return false;
 
-    QPainterPath path;
+  auto escape = [](const std::string &str) {
+    QByteArray data;
 
-    int  lastT     = 0;
-    bool lastValue = false;
+    for (const auto &c : str) {
+      if      (c == '"' || c == '\\')
+        data += '\\';
+      else if (uchar(c) < 0x20)
+        continue;
 
-    path.moveTo(x, y);
+      data += c;
+    }
 
-    for (auto &tv : iv.second) {
-      int  t     = tv.first;
-      bool value = tv.second;
+    return data;
+  };
 
-      if (t == lastT) {
-        path.lineTo(x + dx*t, y + dy1*lastValue);
-        path.lineTo(x + dx*t, y + dy1*value    );
-      }
-      else {
-        path.lineTo(x + dx*lastT, y + dy1*value);
-        path.lineTo(x + dx*t    , y + dy1*value);
-      }
+  QByteArray data("{\"traceEvents\":[\n");
 
-      lastT     = t;
-      lastValue = value;
-    }
+  bool first = true;
 
-    painter.drawPath(path);
+  for (const auto &event : events_) {
+    if (! first)
+      data += ",\n";
 
-    y += 16;
-  }
-}
+    data += "{\"name\":\"" + escape(event.name ? std::string(event.name) : event.str) + "\",\"cat\":\"" + event.cat +
+            "\",\"ph\":\"X\",\"ts\":" + QByteArray::number(event.ts, 'f', 3) +
+            ",\"dur\":" + QByteArray::number(event.dur, 'f', 3) + ",\"pid\":1,\"tid\":1}";
 
-void
-Waveform::
-addValue(const Connection *connection, int t, bool b)
-{
-  auto p = connInds_.find(connection);
+    first = false;
 
-  if (p == connInds_.end()) {
-    p = connInds_.insert(p, ConnInds::value_type(connection, indValues_.size()));
+    // write in 1MB blocks
+    if (data.size() > (1 << 20)) {
+      if (file.write(data) != data.size())
+        return false;
 
-    indConns_[(*p).second] = connection;
+      data.clear();
+    }
   }
 
-  indValues_[(*p).second][t] = b;
-}
+  data += "\n],\"displayTimeUnit\":\"ms\"}\n";
 
-QSize
-Waveform::
-sizeHint() const
-{
-  return QSize(100, 800);
+  return (file.write(data) == data.size());
 }
 
 //---
 
 Gate::
 Gate(const QString &name) :
- name_(name)
+ nameInd_(NameTable::intern(name))
 {
 }
 
@@ -6372,6 +11161,27 @@ Gate::
     delete port;
 }
 
+size_t
+Gate::
+heapBytes() const
+{
+  return (inputs_.capacity() + outputs_.capacity())*sizeof(Port *);
+}
+
+QString
+Gate::
+name() const
+{
+  QString name = localName();
+
+  for (auto *group = placementGroup_; group; group = group->parent()) {
+    if (group->hasIndexName())
+      name += "_" + group->indexName();
+  }
+
+  return name;
+}
+
 QSizeF
 Gate::
 calcSize() const
@@ -6851,12 +11661,85 @@ placePortsOnSide(Port **ports, int n, const Side &side) const
   }
 }
 
+//---
+
+struct Gate::PortTable {
+  using Names   = std::vector<QString>;
+  using NameInd = QHash<QString, int>;
+
+  int     ni { 0 };
+  int     no { 0 };
+  Names   names;
+  NameInd nameInd;
+};
+
+using PortTables = std::unordered_map<std::type_index, Gate::PortTable>;
+
+static PortTables &
+portTables()
+{
+  static PortTables portTables;
+
+  return portTables;
+}
+
+int
+Gate::
+portIndex(const QString &name) const
+{
+  auto ni = int(inputs_ .size());
+  auto no = int(outputs_.size());
+
+  // build table for gate type from first gate of type looked up
+  if (! portTable_) {
+    auto &portTable = portTables()[std::type_index(typeid(*this))];
+
+    if (portTable.names.empty() && ni + no > 0) {
+      portTable.ni = ni;
+      portTable.no = no;
+
+      for (auto &port : inputs_)
+        portTable.names.push_back(port->name());
+
+      for (auto &port : outputs_)
+        portTable.names.push_back(port->name());
+
+      for (int i = ni + no - 1; i >= 0; --i)
+        portTable.nameInd[portTable.names[uint(i)]] = i;
+    }
+
+    portTable_ = &portTable;
+  }
+
+  if (portTable_->ni == ni && portTable_->no == no)
+    return portTable_->nameInd.value(name, -1);
+
+  // ports differ from type so search
+  for (int i = 0; i < ni + no; ++i) {
+    if (portByIndex(i)->name() == name)
+      return i;
+  }
+
+  return -1;
+}
+
 void
 Gate::
 connect(const QString &name, Connection *connection)
 {
-  Port *port = getPortByName(name);
-  assert(port);
+  int ind = portIndex(name);
+  assert(ind >= 0);
+
+  connect(ind, connection);
+}
+
+void
+Gate::
+connect(int portIndex, Connection *connection)
+{
+  assert(portIndex >= 0 && portIndex < int(inputs_.size() + outputs_.size()));
+
+  Port *port = portByIndex(portIndex);
 
   if (port->direction() == Direction::IN)
     connection->addOutPort(port);
@@ -6870,7 +11753,7 @@ void
 Gate::
 addInputPort(const QString &name)
 {
-  Port *port = new Port(name, Direction::IN);
+  Port *port = new Port(internPortName(name), Direction::IN);
 
   port->setGate(this);
 
@@ -6881,28 +11764,77 @@ void
 Gate::
 addOutputPort(const QString &name)
 {
-  Port *port = new Port(name, Direction::OUT);
+  Port *port = new Port(internPortName(name), Direction::OUT);
 
   port->setGate(this);
 
   outputs_.push_back(port);
 }
 
+const QString &
+Gate::
+internPortName(const QString &name) const
+{
+  // share name string with table of gate type if already built
+  // (type is class being constructed when called from constructor).
+  // Looked up by name as ports may be added in any input/output order
+  auto p = portTables().find(std::type_index(typeid(*this)));
+
+  if (p != portTables().end()) {
+    const PortTable &portTable = (*p).second;
+
+    int ind = portTable.nameInd.value(name, -1);
+
+    if (ind >= 0)
+      return portTable.names[uint(ind)];
+  }
+
+  return name;
+}
+
 Port *
 Gate::
 getPortByName(const QString &name) const
 {
-  for (auto &p : inputs()) {
-    if (p->name() == name)
-      return p;
-  }
+  int ind = portIndex(name);
 
-  for (auto &p : outputs()) {
-    if (p->name() == name)
-      return p;
-  }
+  return (ind >= 0 ? portByIndex(ind) : nullptr);
+}
 
-  return nullptr;
+void
+Gate::
+connections(Connections &connections) const
+{
+  std::set<Connection *> connectionSet;
+
+  auto addPortConnection = [&](Port *port) {
+    Connection *connection = port->connection();
+
+    if (connection && connectionSet.find(connection) == connectionSet.end()) {
+      connectionSet.insert(connection);
+
+      connections.push_back(connection);
+    }
+  };
+
+  for (auto &port : inputs())
+    addPortConnection(port);
+
+  for (auto &port : outputs())
+    addPortConnection(port);
+}
+
+void
+Gate::
+translatePixelRect(double dx, double dy) const
+{
+  prect_.translate(dx, dy);
+
+  for (auto &port : inputs())
+    port->setPixelPos(port->pixelPos() + QPointF(dx, dy));
+
+  for (auto &port : outputs())
+    port->setPixelPos(port->pixelPos() + QPointF(dx, dy));
 }
 
 void
@@ -7621,6 +12553,28 @@ RegisterGate(const QString &name) :
   addInputPorts(QStringList() << "s" << "e");
 }
 
+uchar
+RegisterGate::
+stateBits() const
+{
+  uchar bits = 0;
+
+  for (uint i = 0; i < 8; ++i) {
+    if (state_[i])
+      bits = uchar(bits | (1 << i));
+  }
+
+  return bits;
+}
+
+void
+RegisterGate::
+setStateBits(uchar bits)
+{
+  for (uint i = 0; i < 8; ++i)
+    state_[i] = (bits & (1 << i));
+}
+
 bool
 RegisterGate::
 exec()
@@ -7676,6 +12630,179 @@ draw(Renderer *renderer) const
 
 //---
 
+RamArrayGate::
+RamArrayGate(const QString &name, int nr, int nc) :
+ Gate(name), nr_(nr), nc_(nc)
+{
+  w_ = 2.0;
+  h_ = 2.0;
+
+  for (int r = 0; r < nr_; ++r)
+    addInputPort(RamArrayGate::hname(r));
+
+  for (int c = 0; c < nc_; ++c)
+    addInputPort(RamArrayGate::vname(c));
+
+  for (int i = 0; i < 8; ++i)
+    addInputPort(RamArrayGate::iname(i));
+
+  addInputPorts(QStringList() << "s" << "e");
+
+  for (int i = 0; i < 8; ++i)
+    addOutputPort(RamArrayGate::oname(i));
+
+  auto n = uint(nr_*nc_);
+
+  nets_  .resize(n);
+  state_ .resize(n);
+  output_.resize(n);
+}
+
+void
+RamArrayGate::
+setCellState(int i, uchar state)
+{
+  // outputs recalculated on next exec
+  state_ [uint(i)] = state;
+  nets_  [uint(i)] = 0;
+  output_[uint(i)] = 0;
+}
+
+size_t
+RamArrayGate::
+heapBytes() const
+{
+  return Gate::heapBytes() + nets_.capacity() + state_.capacity() + output_.capacity();
+}
+
+bool
+RamArrayGate::
+exec()
+{
+  auto ib = uint(nr_ + nc_);
+
+  bool s = inputs_[ib + 8]->getValue();
+  bool e = inputs_[ib + 9]->getValue();
+
+  bool changed = false;
+
+  uint ind = 0;
+
+  for (int r = 0; r < nr_; ++r) {
+    bool h = inputs_[uint(r)]->getValue();
+
+    for (int c = 0; c < nc_; ++c, ++ind) {
+      bool v = inputs_[uint(nr_ + c)]->getValue();
+
+      uchar nets = nets_[ind];
+
+      // and gates (X, X1, X1)
+      bool t1 = (h && v);
+      bool t2 = (t1 && s);
+      bool t3 = (t1 && e);
+
+      uchar nets1 = uchar((t1 ? T1_BIT : 0) | (t2 ? T2_BIT : 0) | (t3 ? T3_BIT : 0));
+
+      if (nets1 != nets) {
+        nets_[ind] = nets1;
+
+        changed = true;
+      }
+
+      // register (bus inputs may have been changed by previous cell)
+      uchar state  = state_ [ind];
+      uchar output = output_[ind];
+
+      for (uint i = 0; i < 8; ++i) {
+        uchar mask = uchar(1 << i);
+
+        if (t2)
+          state = uchar(inputs_[ib + i]->getValue() ? (state | mask) : (state & ~mask));
+
+        bool iv = (t3 ? (state & mask) : false);
+
+        if (iv != bool(output & mask)) {
+          output = uchar(iv ? (output | mask) : (output & ~mask));
+
+          outputs_[i]->setValue(iv);
+
+          changed = true;
+        }
+      }
+
+      state_ [ind] = state;
+      output_[ind] = output;
+    }
+  }
+
+  return changed;
+}
+
+void
+RamArrayGate::
+draw(Renderer *renderer) const
+{
+  if (! renderer->schem->isGateVisible())
+    return;
+
+  renderer->painter->setPen(penColor(renderer));
+
+  // calc coords
+  initRect(renderer);
+
+  //---
+
+  // draw gate
+  drawRect(renderer);
+
+  // draw cell grid (at most 16 lines per direction) with enabled cells filled
+  int dr = std::max(nr_/16, 1);
+  int dc = std::max(nc_/16, 1);
+
+  double cw = (px2() - px1())/nc_;
+  double ch = (py2() - py1())/nr_;
+
+  for (int r = dr; r < nr_; r += dr)
+    renderer->painter->drawLine(QPointF(px1(), py1() + r*ch), QPointF(px2(), py1() + r*ch));
+
+  for (int c = dc; c < nc_; c += dc)
+    renderer->painter->drawLine(QPointF(px1() + c*cw, py1()), QPointF(px1() + c*cw, py2()));
+
+  uint ind = 0;
+
+  for (int r = 0; r < nr_; ++r) {
+    for (int c = 0; c < nc_; ++c, ++ind) {
+      if (nets_[ind] & T1_BIT)
+        renderer->painter->fillRect(QRectF(px1() + c*cw, py2() - (r + 1)*ch, cw, ch),
+                                    renderer->selectColor);
+    }
+  }
+
+  //---
+
+  // place row ports on left, column ports on bottom, bus inputs on top and
+  // bus outputs, s and e on right
+  auto ib = uint(nr_ + nc_);
+
+  placePortsOnSide(const_cast<Port **>(&inputs_[0]), nr_, Side::LEFT);
+  placePortsOnSide(const_cast<Port **>(&inputs_[uint(nr_)]), nc_, Side::BOTTOM);
+  placePortsOnSide(const_cast<Port **>(&inputs_[ib]), 8, Side::TOP);
+
+  std::vector<Port *> rports;
+
+  for (uint i = 0; i < 8; ++i)
+    rports.push_back(outputs_[i]);
+
+  rports.push_back(inputs_[ib + 8]);
+  rports.push_back(inputs_[ib + 9]);
+
+  placePortsOnSide(&rports[0], int(rports.size()), Side::RIGHT);
+
+  Gate::draw(renderer);
+}
+
+//---
+
 Decoder4Gate::
 Decoder4Gate(const QString &name) :
  Gate(name)
@@ -9336,7 +14463,7 @@ calcSide() const
 
 Connection::
 Connection(const QString &name) :
- name_(name)
+ nameInd_(NameTable::intern(name))
 {
 }
 
@@ -9344,6 +14471,10 @@ void
 Connection::
 setValue(bool b)
 {
+  // count transitions (for heatmap)
+  if (b != value_ && schem_ && schemInd_ >= 0)
+    schem_->addToggle(schemInd_);
+
   value_ = b;
 
   // propagate to output
@@ -9416,6 +14547,18 @@ merge(Connection *connection)
   connection->outPorts_.clear();
 }
 
+void
+Connection::
+removeDisconnectedPorts()
+{
+  auto isDisconnected = [&](const Port *port) { return port->connection() != this; };
+
+  inPorts_ .erase(std::remove_if(inPorts_ .begin(), inPorts_ .end(), isDisconnected),
+                  inPorts_ .end());
+  outPorts_.erase(std::remove_if(outPorts_.begin(), outPorts_.end(), isDisconnected),
+                  outPorts_.end());
+}
+
 void
 Connection::
 removePort(Port *port)
@@ -9475,11 +14618,23 @@ inside(const QPointF &p) const
 
 void
 Connection::
-draw(Renderer *renderer) const
+updateLines(Renderer *renderer) const
 {
-  if (! renderer->schem->isConnectionVisible())
+  if (linesValid_)
     return;
 
+  linesValid_ = true;
+
+  // release channels used by previous route
+  RouteChannels *channels = (renderer->schem ? &renderer->schem->routeChannels() : nullptr);
+
+  if (channels)
+    releaseChannels(*channels);
+
+  lines_.clear();
+
+  linesRect_ = QRectF();
+
   auto ni = inPorts_ .size();
   auto no = outPorts_.size();
 
@@ -9504,8 +14659,6 @@ draw(Renderer *renderer) const
     points.push_back(SidePoint(QPoint(int(p.x()), int(p.y())), side, Direction::IN));
   }
 
-  lines_.clear();
-
   if (ni + no == 1)
     calcSinglePointLines(renderer, points, lines_);
   else if ((ni > 1 && no == 0) || (no > 1 && ni == 0))
@@ -9619,9 +14772,96 @@ draw(Renderer *renderer) const
     p1 = outPorts_[0]->offsetPixelPos();
     p2 = outPorts_[0]->pixelPos();
 
-    addLine(p1, p2);
-  }
-#endif
+    addLine(p1, p2);
+  }
+#endif
+
+  //---
+
+  // move lines off channels used by other connections and claim used channels
+  if (channels) {
+    assignChannels(*channels);
+
+    claimChannels(*channels);
+  }
+
+  //---
+
+  updateLinesRect();
+}
+
+void
+Connection::
+setLines(Renderer *renderer, const Lines &lines)
+{
+  RouteChannels *channels = (renderer->schem ? &renderer->schem->routeChannels() : nullptr);
+
+  if (channels)
+    releaseChannels(*channels);
+
+  lines_      = lines;
+  linesValid_ = true;
+
+  if (channels)
+    claimChannels(*channels);
+
+  updateLinesRect();
+}
+
+void
+Connection::
+releaseChannels(RouteChannels &channels) const
+{
+  for (const auto &line : lines_) {
+    if      (line.start.y() == line.end.y())
+      channels.removeSegment(this, /*horizontal*/true , int(line.start.y()));
+    else if (line.start.x() == line.end.x())
+      channels.removeSegment(this, /*horizontal*/false, int(line.start.x()));
+  }
+}
+
+void
+Connection::
+claimChannels(RouteChannels &channels) const
+{
+  for (const auto &line : lines_) {
+    if      (line.start.y() == line.end.y())
+      channels.addSegment(this, /*horizontal*/true , int(line.start.y()),
+                          int(line.start.x()), int(line.end.x()));
+    else if (line.start.x() == line.end.x())
+      channels.addSegment(this, /*horizontal*/false, int(line.start.x()),
+                          int(line.start.y()), int(line.end.y()));
+  }
+}
+
+void
+Connection::
+updateLinesRect() const
+{
+  linesRect_ = QRectF();
+
+  for (const auto &line : lines_) {
+    QRectF r = QRectF(line.start, line.end).normalized();
+
+    linesRect_ = (linesRect_.isNull() ? r : linesRect_.united(r));
+  }
+
+  // pad for pen width (also ensures single line rect is not empty)
+  linesRect_.adjust(-2, -2, 2, 2);
+}
+
+void
+Connection::
+draw(Renderer *renderer) const
+{
+  if (! renderer->schem->isConnectionVisible())
+    return;
+
+  if (inPorts_.empty() && outPorts_.empty())
+    return;
+
+  // route lines if ports moved
+  updateLines(renderer);
 
   //---
 
@@ -9658,6 +14898,167 @@ draw(Renderer *renderer) const
     drawLine(renderer, line.start, line.end, /*showText*/ line.ind == ind);
 }
 
+void
+Connection::
+assignChannels(RouteChannels &channels) const
+{
+  static const int TS = 4; // track spacing
+  static const int NT = 4; // max tracks to offset
+
+  auto isPortPoint = [&](const QPointF &p) {
+    QPoint p1(int(p.x()), int(p.y()));
+
+    for (const auto &port : inPorts_) {
+      QPointF pp = port->pixelPos();
+
+      if (QPoint(int(pp.x()), int(pp.y())) == p1)
+        return true;
+    }
+
+    for (const auto &port : outPorts_) {
+      QPointF pp = port->pixelPos();
+
+      if (QPoint(int(pp.x()), int(pp.y())) == p1)
+        return true;
+    }
+
+    return false;
+  };
+
+  struct Attached {
+    uint ind   { 0 };
+    bool start { true };
+
+    Attached(uint ind, bool start) :
+     ind(ind), start(start) {
+    }
+  };
+
+  using AttachedList = std::vector<Attached>;
+
+  auto nl = lines_.size();
+
+  for (uint i = 0; i < nl; ++i) {
+    Line &line = lines_[i];
+
+    bool horizontal = (line.start.y() == line.end.y());
+    bool vertical   = (line.start.x() == line.end.x());
+
+    if (horizontal == vertical)
+      continue;
+
+    int pos   = int(horizontal ? line.start.y() : line.start.x());
+    int start = int(horizontal ? line.start.x() : line.start.y());
+    int end   = int(horizontal ? line.end  .x() : line.end  .y());
+
+    if (! channels.isUsed(this, horizontal, pos, start, end))
+      continue;
+
+    // lines ending at ports can't be moved
+    if (isPortPoint(line.start) || isPortPoint(line.end))
+      continue;
+
+    //---
+
+    // find lines of this connection which end on this line (must all be perpendicular)
+    int smin = std::min(start, end);
+    int smax = std::max(start, end);
+
+    auto onLine = [&](const QPointF &p) {
+      int p1 = int(horizontal ? p.y() : p.x());
+      int p2 = int(horizontal ? p.x() : p.y());
+
+      return (p1 == pos && p2 >= smin && p2 <= smax);
+    };
+
+    AttachedList attached;
+
+    bool movable = true;
+
+    for (uint j = 0; movable && j < nl; ++j) {
+      if (j == i)
+        continue;
+
+      const Line &line1 = lines_[j];
+
+      bool startOn = onLine(line1.start);
+      bool endOn   = onLine(line1.end);
+
+      if (! startOn && ! endOn)
+        continue;
+
+      bool horizontal1 = (line1.start.y() == line1.end.y());
+
+      if (horizontal1 == horizontal || (startOn && endOn)) {
+        movable = false;
+        break;
+      }
+
+      const QPointF &p = (startOn ? line1.start : line1.end);
+
+      if (isPortPoint(p)) {
+        movable = false;
+        break;
+      }
+
+      attached.push_back(Attached(j, startOn));
+    }
+
+    if (! movable)
+      continue;
+
+    //---
+
+    // find nearest free channel which keeps attached lines in same direction
+    for (int t = 1; t <= 2*NT; ++t) {
+      int d    = (t & 1 ? 1 : -1)*((t + 1)/2)*TS;
+      int pos1 = pos + d;
+
+      if (channels.isUsed(this, horizontal, pos1, start, end))
+        continue;
+
+      bool valid = true;
+
+      for (const auto &a : attached) {
+        const Line &line1 = lines_[a.ind];
+
+        const QPointF &p = (a.start ? line1.end : line1.start);
+
+        int o = int(horizontal ? p.y() : p.x());
+
+        if ((o - pos)*(o - pos1) <= 0) {
+          valid = false;
+          break;
+        }
+      }
+
+      if (! valid)
+        continue;
+
+      //---
+
+      // move line and ends of attached lines to new channel
+      auto setPos = [&](QPointF &p) {
+        if (horizontal)
+          p.setY(pos1);
+        else
+          p.setX(pos1);
+      };
+
+      setPos(line.start);
+      setPos(line.end);
+
+      for (const auto &a : attached) {
+        Line &line1 = lines_[a.ind];
+
+        setPos(a.start ? line1.start : line1.end);
+      }
+
+      break;
+    }
+  }
+}
+
 void
 Connection::
 calcSinglePointLines(Renderer *, const SidePoints &points, Lines &lines) const
@@ -9797,29 +15198,32 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
     }
   };
 
+  // routing grid of unique (compressed) x and y values with dense array of nodes
+  // for each x/y pair. Storage is reused between calls so no allocation is needed
+  // once it has grown to the size of the largest connection
   class GridData {
    public:
-    using IVals       = std::map<int, int>;
-    using XConnected  = std::map<int, GridNode>;
-    using XYConnected = std::map<int, XConnected>;
+    using IVals = std::vector<int>;
+    using Nodes = std::vector<GridNode>;
 
    public:
     GridData() { }
 
-    void addPoint(const QPoint &p, int ncon=-1, const Side &side=Side::NONE) {
-      auto px = xvals_.find(p.x());
-      auto py = yvals_.find(p.y());
-
-      if (px == xvals_.end())
-        xvals_[p.x()] = 0;
-
-      if (py == yvals_.end())
-        yvals_[p.y()] = 0;
+    void reset() {
+      xvals_     .clear();
+      yvals_     .clear();
+      nodes_     .clear();
+      nodePoints_.clear();
+      lines_     .clear();
+    }
 
-      auto ci = connected_.find(p.y());
+    // add point (grid must not be initialized)
+    void addPoint(const QPoint &p, int ncon=-1, const Side &side=Side::NONE) {
+      xvals_.push_back(p.x());
+      yvals_.push_back(p.y());
 
-      if (ci == connected_.end() || (ci->second.find(p.x()) == ci->second.end()))
-        connected_[p.y()][p.x()] = GridNode(ncon, side);
+      if (ncon >= 0 || side != Side::NONE)
+        nodePoints_.push_back(NodePoint(p, GridNode(ncon, side)));
     }
 
     void addExtraPoints(int ds) {
@@ -9829,211 +15233,145 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
       int y1 = this->y1();
       int y2 = this->y2();
 
-      //int w = std::max(x2 - x1, ds);
-      //int h = std::max(y2 - y1, ds);
-
       int xm = int((x1 + x2)/2.0);
       int ym = int((y1 + y2)/2.0);
 
-      std::set<int> xv, yv;
+      for (int x = xm; x >= x1 - ds; x -= ds) xvals_.push_back(x);
+      for (int x = xm; x <= x2 + ds; x += ds) xvals_.push_back(x);
 
-      for (int x = xm; x >= x1 - ds; x -= ds) xv.insert(x);
-      for (int x = xm; x <= x2 + ds; x += ds) xv.insert(x);
-
-      for (int y = ym; y >= y1 - ds; y -= ds) yv.insert(y);
-      for (int y = ym; y <= y2 + ds; y += ds) yv.insert(y);
-
-      for (const auto &y : yv)
-        for (const auto &x : xv)
-          addPoint(QPoint(x, y));
+      for (int y = ym; y >= y1 - ds; y -= ds) yvals_.push_back(y);
+      for (int y = ym; y <= y2 + ds; y += ds) yvals_.push_back(y);
 
       //---
 
-      for (const auto &yc : connected_) {
-        for (const auto &xc : yc.second) {
-          if      (xc.second.side == Side::LEFT)
-            addPoint(QPoint(xc.first - ds, yc.first));
-          else if (xc.second.side == Side::RIGHT)
-            addPoint(QPoint(xc.first + ds, yc.first));
-          else if (xc.second.side == Side::TOP)
-            addPoint(QPoint(xc.first, yc.first - ds));
-          else if (xc.second.side == Side::BOTTOM)
-            addPoint(QPoint(xc.first, yc.first + ds));
-        }
+      // keep first node added at each point (ports are added in ncon order)
+      std::sort(nodePoints_.begin(), nodePoints_.end(),
+        [](const NodePoint &np1, const NodePoint &np2) {
+          int c = cmp(np1.p, np2.p);
+          if (c != 0) return (c < 0);
+          return (np1.node.ncon < np2.node.ncon);
+        });
+
+      nodePoints_.erase(std::unique(nodePoints_.begin(), nodePoints_.end(),
+        [](const NodePoint &np1, const NodePoint &np2) {
+          return (cmp(np1.p, np2.p) == 0);
+        }), nodePoints_.end());
+
+      for (const auto &np : nodePoints_) {
+        const QPoint &p = np.p;
+
+        if      (np.node.side == Side::LEFT)
+          addPoint(QPoint(p.x() - ds, p.y()));
+        else if (np.node.side == Side::RIGHT)
+          addPoint(QPoint(p.x() + ds, p.y()));
+        else if (np.node.side == Side::TOP)
+          addPoint(QPoint(p.x(), p.y() - ds));
+        else if (np.node.side == Side::BOTTOM)
+          addPoint(QPoint(p.x(), p.y() + ds));
       }
     }
 
+    // compress x and y values and create node for every x/y pair
     void initConnected() {
-      for (const auto &py : yvals_) {
-        auto pcy = connected_.find(py.first);
-
-        for (const auto &px : xvals_) {
-          bool found = (pcy != connected_.end());
+      std::sort(xvals_.begin(), xvals_.end());
+      std::sort(yvals_.begin(), yvals_.end());
 
-          if (found) {
-            auto pcxy = pcy->second.find(px.first);
+      xvals_.erase(std::unique(xvals_.begin(), xvals_.end()), xvals_.end());
+      yvals_.erase(std::unique(yvals_.begin(), yvals_.end()), yvals_.end());
 
-            found = (pcxy != pcy->second.end());
-          }
-
-          if (! found)
-            connected_[py.first][px.first] = GridNode();
-        }
-      }
-    }
-
-    int x1() const { return xvals_.begin ()->first; }
-    int x2() const { return xvals_.rbegin()->first; }
-    int y1() const { return yvals_.begin ()->first; }
-    int y2() const { return yvals_.rbegin()->first; }
-
-    int prevX(int x, bool &ok) {
-      auto px = xvals_.find(x);
-      assert(px != xvals_.end());
-
-      --px;
-
-      ok = (px != xvals_.end());
-
-      if (! ok)
-        return x;
-
-      return px->first;
-    }
-
-    int nextX(int x, bool &ok) {
-      auto px = xvals_.find(x);
-      assert(px != xvals_.end());
-
-      ++px;
-
-      ok = (px != xvals_.end());
-
-      if (! ok)
-        return x;
+      nodes_.assign(xvals_.size()*yvals_.size(), GridNode());
 
-      return px->first;
+      for (const auto &np : nodePoints_)
+        nodeAt(xind(np.p.x()), yind(np.p.y())) = np.node;
     }
 
-    int prevY(int y, bool &ok) {
-      auto py = yvals_.find(y);
-      assert(py != yvals_.end());
-
-      --py;
-
-      ok = (py != yvals_.end());
-
-      if (! ok)
-        return y;
-
-      return py->first;
-    }
-
-    int nextY(int y, bool &ok) {
-      auto py = yvals_.find(y);
-      assert(py != yvals_.end());
-
-      ++py;
-
-      ok = (py != yvals_.end());
-
-      if (! ok)
-        return y;
-
-      return py->first;
-    }
+    int x1() const { return *std::min_element(xvals_.begin(), xvals_.end()); }
+    int x2() const { return *std::max_element(xvals_.begin(), xvals_.end()); }
+    int y1() const { return *std::min_element(yvals_.begin(), yvals_.end()); }
+    int y2() const { return *std::max_element(yvals_.begin(), yvals_.end()); }
 
     QPoint nextPoint(const QPoint &p, const Side &side, int &ncon, bool &ok) {
-      ok = false;
+      int ix = xind(p.x());
+      int iy = yind(p.y());
 
-      QPoint p1 = p;
+      ok = false;
 
       if      (side == Side::LEFT) {
-        p1 = QPoint(prevX(p.x(), ok), p.y());
+        ok = (ix > 0);
+
+        if (ok) --ix;
       }
       else if (side == Side::RIGHT) {
-        p1 = QPoint(nextX(p.x(), ok), p.y());
+        ok = (ix < int(xvals_.size()) - 1);
+
+        if (ok) ++ix;
       }
       else if (side == Side::TOP) {
-        p1 = QPoint(p.x(), prevY(p.y(), ok));
+        ok = (iy > 0);
+
+        if (ok) --iy;
       }
       else if (side == Side::BOTTOM) {
-        p1 = QPoint(p.x(), nextY(p.y(), ok));
+        ok = (iy < int(yvals_.size()) - 1);
+
+        if (ok) ++iy;
       }
 
       //---
 
-      auto pcy = connected_.find(p1.y());
-      assert(pcy != connected_.end());
-
-      auto pcxy = pcy->second.find(p1.x());
-      assert(pcxy != pcy->second.end());
+      ncon = nodeAt(ix, iy).ncon;
 
-      ncon = pcxy->second.ncon;
-
-      return p1;
+      return QPoint(xvals_[uint(ix)], yvals_[uint(iy)]);
     }
 
     void setConnected(const QPoint &p, int ncon) {
-      auto pcy = connected_.find(p.y());
-      assert(pcy != connected_.end());
-
-      auto pcxy = pcy->second.find(p.x());
-      assert(pcxy != pcy->second.end());
+      GridNode &node = nodeAt(xind(p.x()), yind(p.y()));
 
       if (ncon >= 0)
-        assert(pcxy->second.ncon == -1);
+        assert(node.ncon == -1);
 
-      pcxy->second.ncon = ncon;
+      node.ncon = ncon;
     }
 
+    // debug lines
     void addLine(const QPoint &p1, const QPoint &p2) {
       if (cmp(p1, p2) < 0)
-        lines_[p1].insert(p2);
+        lines_.push_back(PointPair(p1, p2));
       else
-        lines_[p2].insert(p1);
+        lines_.push_back(PointPair(p2, p1));
     }
 
     bool isLine(const QPoint &p1, const QPoint &p2) const {
       assert(cmp(p1, p2) < 0);
 
-      auto i1 = lines_.find(p1);
-      if (i1 == lines_.end()) return false;
-
-      auto i2 = i1->second.find(p2);
-      if (i2 == i1->second.end()) return false;
+      for (const auto &line : lines_) {
+        if (cmp(line.first, p1) == 0 && cmp(line.second, p2) == 0)
+          return true;
+      }
 
-      return true;
+      return false;
     }
 
     void print(std::ostream &os) {
-      bool yfirst = true;
-
-      int y1 = 0, y2 = 0;
+      int nx = int(xvals_.size());
+      int ny = int(yvals_.size());
 
-      for (const auto &yc : connected_) {
-        y1 = y2;
-        y2 = yc.first;
+      for (int iy = 0; iy < ny; ++iy) {
+        int y2 = yvals_[uint(iy)];
 
-        //---
-
-        bool xfirst = true;
+        if (iy > 0) {
+          int y1 = yvals_[uint(iy - 1)];
 
-        if (! yfirst) {
-          for (const auto &xc : yc.second) {
-            int x = xc.first;
+          for (int ix = 0; ix < nx; ++ix) {
+            int x = xvals_[uint(ix)];
 
-            //---
-
-            if (! xfirst)
+            if (ix > 0)
               os << "  ";
 
             if (isLine(QPoint(x, y1), QPoint(x, y2)))
-              os << (xc.second.ncon >= 0 ? "#" : "#");
+              os << "#";
             else
-              os << (xc.second.ncon >= 0 ? "|" : "|");
-
-            xfirst = false;
+              os << "|";
           }
 
           os << "\n";
@@ -10041,25 +15379,21 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
 
         //---
 
-        xfirst = true;
+        for (int ix = 0; ix < nx; ++ix) {
+          const GridNode &node = nodeAt(ix, iy);
 
-        int x1 = 0, x2 = 0;
+          if (ix > 0) {
+            int x1 = xvals_[uint(ix - 1)];
+            int x2 = xvals_[uint(ix)];
 
-        for (const auto &xc : yc.second) {
-          x1 = x2;
-          x2 = xc.first;
-
-          //---
-
-          if (! xfirst) {
             if (isLine(QPoint(x1, y2), QPoint(x2, y2)))
               os << "==";
             else
               os << "--";
           }
 
-          if (xc.second.side != Side::NONE) {
-            switch (xc.second.side) {
+          if (node.side != Side::NONE) {
+            switch (node.side) {
               case Side::LEFT  : os << "L"; break;
               case Side::RIGHT : os << "R"; break;
               case Side::TOP   : os << "T"; break;
@@ -10068,19 +15402,13 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
             }
           }
           else {
-            if (xc.second.ncon >= 0)
-              os << xc.second.ncon;
+            if (node.ncon >= 0)
+              os << node.ncon;
             else
               os << ".";
           }
-
-          xfirst = false;
         }
 
-        //---
-
-        yfirst = false;
-
         os << "\n";
       }
     }
@@ -10095,11 +15423,11 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
       int y2 = this->y2();
 
       for (const auto &x : xvals_) {
-        Schematic::drawLine(renderer, QPointF(x.first, y1), QPoint(x.first, y2));
+        Schematic::drawLine(renderer, QPointF(x, y1), QPoint(x, y2));
       }
 
       for (const auto &y : yvals_) {
-        Schematic::drawLine(renderer, QPointF(x1, y.first), QPoint(x2, y.first));
+        Schematic::drawLine(renderer, QPointF(x1, y), QPoint(x2, y));
       }
     }
 
@@ -10111,23 +15439,88 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
       return 0;
     }
 
-    struct PointCmp {
-      bool operator()(const QPoint &p1, const QPoint &p2) const {
-        return cmp(p1, p2) < 0;
+   private:
+    int xind(int x) const {
+      auto px = std::lower_bound(xvals_.begin(), xvals_.end(), x);
+      assert(px != xvals_.end() && *px == x);
+
+      return int(px - xvals_.begin());
+    }
+
+    int yind(int y) const {
+      auto py = std::lower_bound(yvals_.begin(), yvals_.end(), y);
+      assert(py != yvals_.end() && *py == y);
+
+      return int(py - yvals_.begin());
+    }
+
+    GridNode &nodeAt(int ix, int iy) {
+      return nodes_[uint(iy)*xvals_.size() + uint(ix)];
+    }
+
+    const GridNode &nodeAt(int ix, int iy) const {
+      return nodes_[uint(iy)*xvals_.size() + uint(ix)];
+    }
+
+   private:
+    struct NodePoint {
+      QPoint   p;
+      GridNode node;
+
+      NodePoint(const QPoint &p, const GridNode &node) :
+       p(p), node(node) {
       }
     };
 
-   private:
-    using PointSet      = std::set<QPoint, PointCmp>;
-    using PointPointSet = std::map<QPoint, PointSet, PointCmp>;
+    using NodePoints = std::vector<NodePoint>;
+    using PointPair  = std::pair<QPoint, QPoint>;
+    using PointPairs = std::vector<PointPair>;
 
-    IVals         xvals_;
-    IVals         yvals_;
-    XYConnected   connected_;
-    PointPointSet lines_;
+    IVals      xvals_;
+    IVals      yvals_;
+    Nodes      nodes_;
+    NodePoints nodePoints_;
+    PointPairs lines_;
   };
 
-  GridData grid;
+  struct TargetPoint {
+    QPoint p;
+    int    ncon { -1 };
+
+    TargetPoint(const QPoint &p, int ncon) :
+     p(p), ncon(ncon) {
+    }
+  };
+
+  using TargetPoints = std::vector<TargetPoint>;
+
+  struct MinData {
+    double d     { 0.0 };
+    QPoint p;
+    bool   found { false };
+  };
+
+  using MinDatas = std::vector<MinData>;
+
+  // per thread workspace reused for each connection
+  struct Workspace {
+    GridData     grid;
+    LinesData    linesData;
+    SidePoints   points;
+    TargetPoints targetPoints;
+    MinDatas     conMinData;
+  };
+
+  static thread_local Workspace workspace;
+
+  GridData     &grid         = workspace.grid;
+  LinesData    &linesData    = workspace.linesData;
+  TargetPoints &targetPoints = workspace.targetPoints;
+  MinDatas     &conMinData   = workspace.conMinData;
+
+  grid        .reset();
+  linesData   .clear();
+  targetPoints.clear();
 
   //---
 
@@ -10145,8 +15538,6 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
 
   //---
 
-  LinesData linesData;
-
 #if 0
   int x1 = grid.x1();
   int x2 = grid.x2();
@@ -10177,7 +15568,9 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
 
   //---
 
-  SidePoints points1 = points;
+  SidePoints &points1 = workspace.points;
+
+  points1.assign(points.begin(), points.end());
 
   ncon = 0;
 
@@ -10203,19 +15596,6 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
 
   //---
 
-  struct TargetPoint {
-    QPoint p;
-    int    ncon { -1 };
-
-    TargetPoint(const QPoint &p, int ncon) :
-     p(p), ncon(ncon) {
-    }
-  };
-
-  using TargetPoints = std::vector<TargetPoint>;
-
-  TargetPoints targetPoints;
-
   ncon = 0;
 
   for (auto &dp : points1) {
@@ -10245,19 +15625,11 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
   //--
 
   // find nearest target point
-  struct MinData {
-    double d     { 0.0 };
-    QPoint p;
-    bool   found { false };
-  };
-
-  using ConMinData = std::map<int, MinData>;
-
   ncon = 0;
 
   for (const auto &dp : points1) {
     // get nearest point for each other connection
-    ConMinData conMinData;
+    conMinData.assign(points1.size(), MinData());
 
     bool minFound = false;
 
@@ -10266,7 +15638,7 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
 
       int ncon1 = (ncon > 0 ? 0 : dp1.ncon);
 
-      MinData &minData = conMinData[ncon1];
+      MinData &minData = conMinData[uint(ncon1)];
 
       double d = std::hypot(dp1.p.x() - dp.p.x(), dp1.p.y() - dp.p.y());
 
@@ -10284,8 +15656,8 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
 
     //---
 
-    for (const auto &pc : conMinData) {
-      const MinData &minData = pc.second;
+    for (const auto &minData : conMinData) {
+      if (! minData.found) continue;
 
       //---
 
@@ -10446,7 +15818,7 @@ calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const
     ++ncon;
   }
 
-  if (debug)
+  if (debug && renderer->painter)
     grid.draw(renderer);
 
   lines = linesData.lines();
@@ -10704,6 +16076,16 @@ penColor(Renderer *renderer) const
   if (renderer->schem->insideConnection() == this)
     return renderer->insideColor;
 
+  if (renderer->schem->isHeatmap()) {
+    // blue (no toggles) to red (most toggles) on log scale
+    uint32_t n    = renderer->schem->toggleCount(schemInd_);
+    uint32_t maxN = renderer->schem->maxToggles();
+
+    double f = (maxN > 0 ? std::log1p(double(n))/std::log1p(double(maxN)) : 0.0);
+
+    return QColor::fromHsv(int(240*(1.0 - f)), 255, 255);
+  }
+
   if (getValue())
     return Qt::green;
 
@@ -10730,6 +16112,17 @@ addConnection(Connection *connection, int i)
   connection->setBus(this);
 }
 
+void
+Bus::
+replaceConnection(Connection *oldConnection, Connection *newConnection)
+{
+  int i = connectionIndex(oldConnection);
+
+  oldConnection->setBus(nullptr);
+
+  addConnection(newConnection, i);
+}
+
 int
 Bus::
 connectionIndex(Connection *connection)
@@ -11405,6 +16798,27 @@ removeBus(Bus *bus)
   buses_.pop_back();
 }
 
+void
+PlacementGroup::
+truncate(size_t ng, size_t nc, size_t nb, size_t npg)
+{
+  // remove contents added after counts (removed child groups are deleted)
+  for (auto i = npg; i < placementGroups_.size(); ++i)
+    delete placementGroups_[i].placementGroup;
+
+  auto truncateVector = [](auto &v, size_t n) {
+    if (n < v.size())
+      v.erase(v.begin() + long(n), v.end());
+  };
+
+  truncateVector(gates_          , ng );
+  truncateVector(connections_    , nc );
+  truncateVector(buses_          , nb );
+  truncateVector(placementGroups_, npg);
+
+  rectValid_ = false;
+}
+
 PlacementGroup *
 PlacementGroup::
 addPlacementGroup(const Placement &placement, int nr, int nc, int r1, int c1, int nr1, int nc1,
@@ -11446,8 +16860,10 @@ replacePlacementGroup(Schematic *schem, PlacementGroup *placementGroup)
 
   //---
 
-  // delete old placement
-  PlacementGroup *oldGroup = placementGroups_[i++].placementGroup;
+  // delete old placement (new placement takes its layout slot)
+  PlacementGroupData oldData = placementGroups_[i++];
+
+  PlacementGroup *oldGroup = oldData.placementGroup;
 
   Gates       oldGates;
   Connections oldConnections;
@@ -11470,33 +16886,32 @@ replacePlacementGroup(Schematic *schem, PlacementGroup *placementGroup)
 
   PortConnections portConnections;
 
-  for (auto &gate : oldGates) {
-    for (auto &port : gate->inputs()) {
-      Connection *connection = port->connection();
+  // disconnect ports of old gates and then remove them from each connection in one pass
+  auto disconnectPort = [&](Port *port) {
+    Connection *connection = port->connection();
 
-      if (connection) {
-        ConnectionPorts &connectionPorts = portConnections[connection];
+    if (connection) {
+      ConnectionPorts &connectionPorts = portConnections[connection];
 
-        connectionPorts.names.push_back(port->name());
+      connectionPorts.names.push_back(port->name());
 
-        connection->removePort(port);
-      }
+      port->setConnection(nullptr);
     }
+  };
 
-    for (auto &port : gate->outputs()) {
-      Connection *connection = port->connection();
-
-      if (connection) {
-        ConnectionPorts &connectionPorts = portConnections[connection];
+  for (auto &gate : oldGates) {
+    for (auto &port : gate->inputs())
+      disconnectPort(port);
 
-        connectionPorts.names.push_back(port->name());
+    for (auto &port : gate->outputs())
+      disconnectPort(port);
+  }
 
-        connection->removePort(port);
-      }
-    }
+  for (auto &portConnection : portConnections)
+    portConnection.first->removeDisconnectedPorts();
 
+  for (auto &gate : oldGates)
     schem->removeGate(gate);
-  }
 
   //--
 
@@ -11534,7 +16949,15 @@ replacePlacementGroup(Schematic *schem, PlacementGroup *placementGroup)
 
   placementGroups_.pop_back();
 
-  PlacementGroup *newPlacementGroup = placementGroups_.back().placementGroup;
+  PlacementGroupData &newData = placementGroups_.back();
+
+  newData.r         = oldData.r;
+  newData.c         = oldData.c;
+  newData.nr        = oldData.nr;
+  newData.nc        = oldData.nc;
+  newData.alignment = oldData.alignment;
+
+  PlacementGroup *newPlacementGroup = newData.placementGroup;
 
   //---
 
@@ -11542,29 +16965,55 @@ replacePlacementGroup(Schematic *schem, PlacementGroup *placementGroup)
 
   newPlacementGroup->hierConnections(newConnections);
 
+  // index of first new connection for each name
+  using NameInd = std::map<QString, uint>;
+
+  NameInd nameInd;
+
+  for (uint i1 = 0; i1 < newConnections.size(); ++i1)
+    nameInd.insert(NameInd::value_type(newConnections[i1]->name(), i1));
+
   for (auto &portConnection : portConnections) {
     if (! portConnection.second.valid) continue;
 
     Connection *connection = portConnection.first;
 
-    for (auto &newConnection : newConnections) {
-      for (const auto &name : portConnection.second.names) {
-        if (newConnection->name() == name) {
-          newConnection->merge(connection);
+    // merge into first new connection matching any port name
+    uint ind = uint(newConnections.size());
 
-          schem->removeConnection(connection);
+    for (const auto &name : portConnection.second.names) {
+      auto p = nameInd.find(name);
 
-          portConnection.second.valid = false;
+      if (p != nameInd.end())
+        ind = std::min(ind, (*p).second);
+    }
 
-          break;
-        }
+    // otherwise merge into new connection of same name (e.g. collapse of cell
+    // array where all cells use same port names)
+    if (ind >= newConnections.size()) {
+      auto p = nameInd.find(connection->name());
 
-        if (! portConnection.second.valid)
-          break;
-      }
+      if (p != nameInd.end())
+        ind = (*p).second;
+    }
+
+    if (ind < newConnections.size()) {
+      newConnections[ind]->merge(connection);
+
+      // keep external bus bit pointing at merged connection
+      Bus *bus = connection->bus();
+
+      if (bus && ! newConnections[ind]->bus())
+        bus->replaceConnection(connection, newConnections[ind]);
+
+      schem->removeConnection(connection);
+
+      portConnection.second.valid = false;
     }
   }
 
+  schem->compactObjs();
+
   //---
 
   return newPlacementGroup;
@@ -11667,6 +17116,8 @@ void
 PlacementGroup::
 place()
 {
+  Trace::Scope trace("layout", "PlacementGroup::place");
+
   w_ = 0.0;
   h_ = 0.0;
 
@@ -5,13 +5,19 @@
 #include <CDisplayTransform2D.h>
 #include <QFrame>
 #include <QPainter>
+#include <algorithm>
+#include <chrono>
+#include <map>
 #include <set>
+#include <unordered_map>
+#include <cassert>
 
 class QSplitter;
 class QLabel;
 class QToolButton;
 class QPainter;
 class QTimer;
+class QFile;
 
 namespace CQSchem {
 
@@ -63,12 +69,446 @@ using SidePoints = std::vector<SidePoint>;
 
 class Schematic;
 class Waveform;
+class StatsPanel;
+class MemoryPanel;
 class Gate;
 class Port;
 class Connection;
 class Bus;
 class PlacementGroup;
 
+//---
+
+// shared occupancy index of routed horizontal and vertical line channels (pixel coords)
+// used to keep connections routed in a single pass off each other's line channels
+class RouteChannels {
+ public:
+  RouteChannels() { }
+
+  void clear() { hchannels_.clear(); vchannels_.clear(); }
+
+  void addSegment(const Connection *connection, bool horizontal, int pos, int start, int end) {
+    Channels &channels = (horizontal ? hchannels_ : vchannels_);
+
+    channels[pos].push_back(Segment(std::min(start, end), std::max(start, end), connection));
+  }
+
+  void removeSegment(const Connection *connection, bool horizontal, int pos) {
+    Channels &channels = (horizontal ? hchannels_ : vchannels_);
+
+    auto p = channels.find(pos);
+    if (p == channels.end()) return;
+
+    Segments &segments = (*p).second;
+
+    segments.erase(std::remove_if(segments.begin(), segments.end(),
+      [&](const Segment &s) { return s.connection == connection; }), segments.end());
+
+    if (segments.empty())
+      channels.erase(p);
+  }
+
+  // is range of channel used by other connection
+  bool isUsed(const Connection *connection, bool horizontal, int pos, int start, int end) const {
+    const Channels &channels = (horizontal ? hchannels_ : vchannels_);
+
+    auto p = channels.find(pos);
+    if (p == channels.end()) return false;
+
+    int start1 = std::min(start, end);
+    int end1   = std::max(start, end);
+
+    for (const auto &s : (*p).second) {
+      if (s.connection != connection && s.start <= end1 && s.end >= start1)
+        return true;
+    }
+
+    return false;
+  }
+
+  int numChannels() const { return int(hchannels_.size() + vchannels_.size()); }
+
+ private:
+  struct Segment {
+    int               start      { 0 };
+    int               end        { 0 };
+    const Connection* connection { nullptr };
+
+    Segment(int start, int end, const Connection *connection) :
+     start(start), end(end), connection(connection) {
+    }
+  };
+
+  using Segments = std::vector<Segment>;
+  using Channels = std::map<int, Segments>;
+
+  Channels hchannels_;
+  Channels vchannels_;
+};
+
+//---
+
+// interned gate and connection names. Objects store a small index into the table
+// instead of their own string so repeated names ("t1", "X", ...) are stored once
+class NameTable {
+ public:
+  static int intern(const QString &name);
+
+  static const QString &name(int ind);
+
+  static int numNames();
+
+  // approximate bytes of names and index
+  static size_t numBytes();
+};
+
+//---
+
+// per schematic arena for gate, port and connection objects. Objects are bump allocated
+// from chunks owned by a pool per (aligned) object size so objects of the same type are
+// contiguous, deleted objects are reused from the pool's free list and all chunks are
+// released together when the schematic is cleared
+class ObjArena {
+ public:
+  ObjArena() { }
+ ~ObjArena();
+
+  ObjArena(const ObjArena &) = delete;
+  ObjArena &operator=(const ObjArena &) = delete;
+
+  static ObjArena *current() { return current_; }
+  static void setCurrent(ObjArena *arena) { current_ = arena; }
+
+  // make arena current for scope (objects created by a schematic use its arena)
+  class CurrentScope {
+   public:
+    CurrentScope(ObjArena *arena) : old_(current_) { current_ = arena; }
+   ~CurrentScope() { current_ = old_; }
+
+    CurrentScope(const CurrentScope &) = delete;
+    CurrentScope &operator=(const CurrentScope &) = delete;
+
+   private:
+    ObjArena *old_ { nullptr };
+  };
+
+  void *alloc(size_t size);
+  void free(void *p, size_t size);
+
+  // free object to arena which owns it (from chunk header)
+  static void freeObj(void *p, size_t size);
+
+  // release all chunks (all objects must have been destroyed)
+  void release();
+
+  size_t numLive() const { return numLive_; }
+
+  size_t numBytes() const { return chunks_.size()*chunkSize; }
+
+ private:
+  static const size_t align     = 16;
+  static const size_t chunkSize = 256*1024; // chunks are aligned to size
+  static const size_t maxSize   = 4096;
+
+  struct FreeObj {
+    FreeObj *next { nullptr };
+  };
+
+  struct Pool {
+    char*    ptr      { nullptr };
+    char*    end      { nullptr };
+    FreeObj* freeList { nullptr };
+  };
+
+  using Pools  = std::vector<Pool>;
+  using Chunks = std::vector<char *>;
+
+  static ObjArena *current_;
+
+  Pools  pools_;
+  Chunks chunks_;
+  size_t numLive_ { 0 };
+};
+
+// allocate class objects from current schematic arena (freed to owning arena)
+#define CQSCHEM_ARENA_ALLOC \
+  static void *operator new(size_t size) { \
+    assert(ObjArena::current()); return ObjArena::current()->alloc(size); } \
+  static void operator delete(void *p, size_t size) { \
+    ObjArena::freeObj(p, size); }
+
+//---
+
+// structurally hashed and-inverter graph of lowered combinational gates.
+// Literals are 2*node + complement (node 0 is constant false), input nodes hold net values
+// and and nodes are stored in topological order so one pass evaluates all logic
+class SimAig {
+ public:
+  SimAig() { clear(); }
+
+  void clear();
+
+  static uint32_t constLit(bool b) { return (b ? 1 : 0); }
+
+  static uint32_t notLit(uint32_t l) { return l ^ 1; }
+
+  uint32_t addInput(Connection *connection);
+
+  uint32_t addAnd(uint32_t l0, uint32_t l1);
+
+  uint32_t addOr (uint32_t l0, uint32_t l1) { return notLit(addAnd(notLit(l0), notLit(l1))); }
+
+  uint32_t addXor(uint32_t l0, uint32_t l1) {
+    return addOr(addAnd(l0, notLit(l1)), addAnd(notLit(l0), l1)); }
+
+  void addOutput(Port *port, uint32_t l);
+
+  bool exec();
+
+  int numNodes () const { return int(values_.size()); }
+  int numInputs() const { return int(inputs_.size()); }
+  int numAnds  () const { return int(ands_.size()); }
+  int numMerged() const { return numMerged_; }
+
+ private:
+  struct Input {
+    uint32_t    node       { 0 };
+    Connection* connection { nullptr };
+  };
+
+  struct And {
+    uint32_t node { 0 };
+    uint32_t l0   { 0 };
+    uint32_t l1   { 0 };
+  };
+
+  struct Output {
+    Port*    port { nullptr };
+    uint32_t l    { 0 };
+  };
+
+  using Inputs  = std::vector<Input>;
+  using Ands    = std::vector<And>;
+  using Outputs = std::vector<Output>;
+  using Values  = std::vector<uchar>;
+  using AndInd  = std::unordered_map<uint64_t, uint32_t>;
+
+  bool value(uint32_t l) const { return values_[l >> 1] ^ (l & 1); }
+
+  uint32_t addNode() { values_.push_back(0); return uint32_t(values_.size() - 1); }
+
+  Inputs  inputs_;
+  Ands    ands_;
+  Outputs outputs_;
+  Values  values_;
+  AndInd  andInd_;
+  int     numMerged_ { 0 };
+};
+
+//---
+
+// paint time per phase over last numFrames frames (last/avg/max) and number of
+// objects drawn and culled per phase in last frame
+class PaintProfile {
+ public:
+  enum class Phase {
+    GATES,
+    ROUTE,
+    CONNECTIONS,
+    BUSES,
+    PLACEMENT,
+    BLIT,
+    OVERLAY,
+    NUM_PHASES
+  };
+
+  static constexpr int numPhases = int(Phase::NUM_PHASES);
+  static constexpr int numFrames = 60;
+
+  // add time from construction to destruction to phase (and trace event if tracing)
+  class Timer {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    Timer(PaintProfile &profile, Phase phase) :
+     profile_(profile), phase_(phase), t_(Clock::now()) {
+    }
+
+   ~Timer();
+
+   private:
+    PaintProfile&     profile_;
+    Phase             phase_;
+    Clock::time_point t_;
+  };
+
+ public:
+  PaintProfile() { }
+
+  static const char *phaseName(Phase phase);
+
+  void startFrame();
+
+  void addTime(Phase phase, double ms) { times_[uint(phase)][uint(frame_)] += ms; }
+
+  void addDrawn(Phase phase, int n=1) { drawn_ [uint(phase)] += n; }
+  void addCulled(Phase phase, int n=1) { culled_[uint(phase)] += n; }
+
+  int numFramesDrawn() const { return numFramesDrawn_; }
+
+  double lastTime(Phase phase) const { return times_[uint(phase)][uint(frame_)]; }
+  double avgTime (Phase phase) const;
+  double maxTime (Phase phase) const;
+
+  // report lines (one per phase)
+  std::vector<QString> lines() const;
+
+  bool dump(const QString &filename) const;
+
+ private:
+  using Times = double[numFrames];
+
+  Times times_ [numPhases] { };
+  int   drawn_ [numPhases] { };
+  int   culled_[numPhases] { };
+  int   frame_             { 0 };
+  int   numFramesDrawn_    { 0 };
+};
+
+//---
+
+// hardware performance counter group (linux perf_event_open) accumulated between
+// start and stop calls. Counters which can't be opened read as zero
+class PerfCounters {
+ public:
+  enum class Counter {
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    NUM_COUNTERS
+  };
+
+  static constexpr int numCounters = int(Counter::NUM_COUNTERS);
+
+ public:
+  PerfCounters() { }
+ ~PerfCounters() { close(); }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  static const char *counterName(Counter counter);
+
+  bool open();
+  void close();
+
+  bool isOpen() const { return fds_[0] >= 0; }
+
+  bool isAvailable(Counter counter) const { return fds_[int(counter)] >= 0; }
+
+  void start();
+  void stop();
+
+  void reset();
+
+  uint64_t value(Counter counter) const { return values_[int(counter)]; }
+
+ private:
+  int      fds_   [numCounters] { -1, -1, -1, -1, -1 };
+  uint64_t ids_   [numCounters] { };
+  uint64_t values_[numCounters] { };
+};
+
+//---
+
+// chrome trace event (complete "X" events) recorder. Enabled when CQSCHEM_TRACE is set
+// to the output file name, events are buffered (up to maxEvents) and written as JSON on exit
+class Trace {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t maxEvents = 1 << 20;
+
+  // record time from construction to destruction as named event. Literal names are
+  // stored as pointers, only QString names are copied
+  class Scope {
+   public:
+    Scope(const char *cat, const char *name) {
+      if (Trace::isEnabled()) {
+        cat_  = cat;
+        name_ = name;
+        t_    = Clock::now();
+      }
+    }
+
+    Scope(const char *cat, const QString &name) {
+      if (Trace::isEnabled()) {
+        cat_ = cat;
+        str_ = name.toStdString();
+        t_   = Clock::now();
+      }
+    }
+
+   ~Scope() {
+      if (! cat_)
+        return;
+
+      if (name_)
+        Trace::instance()->addEvent(cat_, name_, t_, Clock::now());
+      else
+        Trace::instance()->addEvent(cat_, str_, t_, Clock::now());
+    }
+
+   private:
+    const char*       cat_  { nullptr };
+    const char*       name_ { nullptr };
+    std::string       str_;
+    Clock::time_point t_;
+  };
+
+ public:
+  static Trace *instance();
+
+  static bool isEnabled() { return instance()->enabled_; }
+
+ ~Trace();
+
+  // add event for static name (not copied) or dynamic name
+  void addEvent(const char *cat, const char *name,
+                const Clock::time_point &t1, const Clock::time_point &t2);
+  void addEvent(const char *cat, const std::string &name,
+                const Clock::time_point &t1, const Clock::time_point &t2);
+
+  bool write() const;
+
+ private:
+  Trace();
+
+ private:
+  struct Event {
+    const char* cat  { nullptr };
+    const char* name { nullptr }; // static name (str used if null)
+    std::string str;
+    double      ts   { 0.0 }; // us
+    double      dur  { 0.0 }; // us
+  };
+
+  using Events = std::vector<Event>;
+
+  // new event (null if buffer full)
+  Event *newEvent(const char *cat, const Clock::time_point &t1, const Clock::time_point &t2);
+
+  bool              enabled_    { false };
+  QString           filename_;
+  Clock::time_point t0_;
+  Events            events_;
+  size_t            numDropped_ { 0 };
+};
+
+//---
+
 struct Renderer {
   Schematic*          schem           { nullptr };
   QPainter*           painter         { nullptr };
@@ -171,6 +611,9 @@ class PlacementGroup {
     GRID
   };
 
+  // max grid rows/columns accepted from netlist files
+  static constexpr int maxGridSize = 4096;
+
   struct GateData {
     Gate*     gate      { nullptr };
     int       r         { -1 };
@@ -233,6 +676,18 @@ class PlacementGroup {
 
   double area() const { return w_*h_; }
 
+  // size calculated by place()
+  QSizeF placeSize() const { return QSizeF(w_, h_); }
+  void setPlaceSize(const QSizeF &s) { w_ = s.width(); h_ = s.height(); }
+
+  // optional row/column index name ("<r>_<c>") used to qualify names of contained gates
+  bool hasIndexName() const { return indexRow_ >= 0; }
+  QString indexName() const { return QString("%1_%2").arg(indexRow_).arg(indexCol_); }
+  void setIndexName(int r, int c) { indexRow_ = r; indexCol_ = c; }
+
+  int indexRow   () const { return indexRow_; }
+  int indexColumn() const { return indexCol_; }
+
   const QString &expandName() const { return expandName_; }
   void setExpandName(const QString &v) { expandName_ = v; }
 
@@ -244,12 +699,19 @@ class PlacementGroup {
 
   void removeGate(Gate *gate);
 
+  const Connections &connections() const { return connections_; }
+
   void addConnection(Connection *connection);
   void removeConnection(Connection *connection);
 
+  const Buses &buses() const { return buses_; }
+
   void addBus(Bus *bus);
   void removeBus(Bus *bus);
 
+  // remove gates, connections, buses and child groups added after the given counts
+  void truncate(size_t ng, size_t nc, size_t nb, size_t npg);
+
   PlacementGroup *addPlacementGroup(const Placement &placement, int nr, int nc,
                                     int r1=-1, int c1=-1, int nr1=1, int nc1=1,
                                     Alignment alignment=Alignment::CENTER);
@@ -288,6 +750,8 @@ class PlacementGroup {
   PlacementGroups placementGroups_;
   QString         expandName_;
   QString         collapseName_;
+  int             indexRow_             { -1 };
+  int             indexCol_             { -1 };
   QRectF          rect_;
   bool            rectValid_            { false };
   mutable QRectF  prect_;
@@ -303,7 +767,7 @@ class Window : public QFrame {
   Q_OBJECT
 
  public:
-  Window(bool waveform);
+  Window(bool waveform, bool stats=false);
 
   Schematic *schem() const { return schem_; }
 
@@ -330,6 +794,8 @@ class Window : public QFrame {
 
   void collapseBusSlot(bool b);
 
+  void heatmapSlot(bool b);
+
   void playSlot();
   void pauseSlot();
   void stepSlot();
@@ -339,6 +805,7 @@ class Window : public QFrame {
   Schematic*   schem_       { nullptr };
   QLabel*      posLabel_    { nullptr };
   Waveform*    waveform_    { nullptr };
+  StatsPanel*  statsPanel_  { nullptr };
   QTimer*      timer_       { nullptr };
   bool         timerActive_ { false };
   QToolButton* playButton_  { nullptr };
@@ -379,6 +846,12 @@ class Schematic : public QFrame {
 
   //---
 
+  const Gates &gates() const { return gates_; }
+
+  const Connections &connections() const { return connections_; }
+
+  //---
+
   bool isShowConnectionText() const { return showConnectionText_; }
   void setShowConnectionText(bool b) { showConnectionText_ = b; redraw(); }
 
@@ -415,6 +888,31 @@ class Schematic : public QFrame {
   bool isCollapseBus() const { return collapseBus_; }
   void setCollapseBus(bool b) { collapseBus_ = b; redraw(); }
 
+  // color connections by value toggle count
+  bool isHeatmap() const { return heatmap_; }
+  void setHeatmap(bool b) { heatmap_ = b; redraw(); }
+
+  //---
+
+  // per connection value toggle counts (indexed by connection schemInd)
+  void addToggle(int ind) {
+    if (uint(ind) >= toggles_.size())
+      toggles_.resize(std::max(connections_.size(), size_t(ind + 1)));
+
+    uint32_t n = ++toggles_[uint(ind)];
+
+    if (n > maxToggles_)
+      maxToggles_ = n;
+  }
+
+  uint32_t toggleCount(int ind) const {
+    return (uint(ind) < toggles_.size() ? toggles_[uint(ind)] : 0);
+  }
+
+  uint32_t maxToggles() const { return maxToggles_; }
+
+  void resetToggles() { toggles_.clear(); maxToggles_ = 0; }
+
   //---
 
   bool isDebugConnect() const { return debugConnect_; }
@@ -422,6 +920,92 @@ class Schematic : public QFrame {
 
   //---
 
+  // exec optimized ops (constant, dead and fused gates removed) instead of all gates
+  bool isOptimize() const { return optimize_; }
+  void setOptimize(bool b) { optimize_ = b; simValid_ = false; }
+
+  // exec combinational logic as and-inverter graph
+  bool isAig() const { return aig_; }
+  void setAig(bool b) { aig_ = b; simValid_ = false; }
+
+  //---
+
+  // per gate class exec profiling. Stats are slots in a flat array (fixed slots for
+  // non gate ops, then one per gate class), names are only looked up for reports
+  struct GateStat {
+    const char*           name    { nullptr }; // fixed slot name
+    const std::type_info* type    { nullptr }; // gate class (if not fixed)
+    long                  calls   { 0 };
+    long                  changed { 0 };
+    double                time    { 0.0 }; // ms
+  };
+
+  enum class StatSlot {
+    SIM_AIG,
+    NAND_NOT,
+    NOT_NOT,
+    NUM_FIXED
+  };
+
+  using GateStats = std::vector<GateStat>;
+  using StatInds  = std::vector<int>;
+
+  bool isStats() const { return stats_; }
+  void setStats(bool b) { stats_ = b; }
+
+  void setStatsPanel(StatsPanel *statsPanel) { statsPanel_ = statsPanel; }
+
+  const GateStats &gateStats() const { return gateStats_; }
+
+  int statsTicks() const { return statsTicks_; }
+
+  void resetStats() { gateStats_.clear(); gateStatInds_.clear(); statsTicks_ = 0; }
+
+  // report lines (sorted by time)
+  std::vector<QString> statsLines() const;
+
+  void printStats() const;
+
+  //---
+
+  // approximate memory use per object type and subsystem
+  std::vector<QString> memoryLines() const;
+
+  void printMemory() const;
+
+  //---
+
+  // sample hardware counters around exec
+  bool isPerf() const { return perf_; }
+  bool setPerf(bool b);
+
+  const PerfCounters &perfCounters() const { return perfCounters_; }
+
+  long perfTicks() const { return perfTicks_; }
+  long perfEvals() const { return perfEvals_; }
+
+  void resetPerf() { perfCounters_.reset(); perfTicks_ = 0; perfEvals_ = 0; }
+
+  // enable counters once for batch of back-to-back exec calls (e.g. bench loop). Exec
+  // outside a batch (GUI timer ticks) brackets only its own tick
+  void startPerfBatch();
+  void stopPerfBatch();
+
+  // report lines (totals, IPC and per gate evaluation)
+  std::vector<QString> perfLines() const;
+
+  void printPerf() const;
+
+  //---
+
+  // draw paint phase times over schematic
+  bool isShowPaintProfile() const { return showPaintProfile_; }
+  void setShowPaintProfile(bool b) { showPaintProfile_ = b; update(); }
+
+  const PaintProfile &paintProfile() const { return paintProfile_; }
+
+  //---
+
   void clear();
 
   void deselectAll();
@@ -493,12 +1077,15 @@ class Schematic : public QFrame {
   void buildComparator8   ();
   void buildBus0          ();
   void buildBus1          ();
-  void buildRam256        ();
-  void buildRam65536      ();
+  void buildRam256        (bool lazyCells=true);
+  void buildRam65536      (bool lazyCells=true);
+  void buildRamCells      (int n);
+
   void buildAlu           ();
   void buildClk           ();
   void buildClkES         ();
   void buildStepper       ();
+
   void buildControl1      ();
   void buildControl2      ();
   void buildControl3      ();
@@ -506,6 +1093,14 @@ class Schematic : public QFrame {
   void buildControl5      ();
   void testConnection     ();
 
+  void addRamArrayGate(int n);
+  void addRamArrayGate(PlacementGroup *placementGroup, int n, Connection **hout,
+                       Connection **vout, Connection *s, Connection *e, Connection **bus);
+  void addRamCells    (PlacementGroup *placementGroup, int n, Connection **hout,
+                       Connection **vout, Connection *s, Connection *e, Connection **bus);
+
+  void copyRamCellState(PlacementGroup *oldGroup, PlacementGroup *newGroup);
+
   Connection *addConnection(const QString &name);
   void removeConnection(Connection *connection);
 
@@ -561,6 +1156,8 @@ class Schematic : public QFrame {
   Bus *addBus(const QString &name, int n);
   void removeBus(Bus *bus);
 
+  void compactObjs();
+
   PlacementGroup *addPlacementGroup(PlacementGroup::Placement placement=
                                      PlacementGroup::Placement::HORIZONTAL,
                                     int nr=-1, int nc=-1);
@@ -581,12 +1178,20 @@ class Schematic : public QFrame {
 
   void paintEvent(QPaintEvent *) override;
 
+  void drawContents(QPainter *painter);
+
+  void drawOverlay(QPainter *painter);
+
+  void drawPaintProfile(QPainter *painter);
+
   void mousePressEvent  (QMouseEvent *e) override;
   void mouseMoveEvent   (QMouseEvent *e) override;
   void mouseReleaseEvent(QMouseEvent *e) override;
 
   void keyPressEvent(QKeyEvent *e) override;
 
+  void initRenderer(QPainter *painter);
+
   Gate*           nearestGate          (const QPointF &p) const;
   PlacementGroup* nearestPlacementGroup(const QPointF &p) const;
   Connection*     nearestConnection    (const QPointF &p) const;
@@ -616,16 +1221,84 @@ class Schematic : public QFrame {
   static void drawLine(Renderer *renderer, const QPointF &p1, const QPointF &p2);
 
   void redraw();
+  void redrawValues();
+
+  void routeBench(int n);
+
+  // render all to offscreen image file (PNG) at size and zoom (no window needed)
+  bool renderImage(const QString &filename, const QSize &size, double zoom=1.0);
+
+  void invalidateConnections();
+
+  void routeConnections();
+
+  RouteChannels &routeChannels() { return routeChannels_; }
+
+  bool loadLayoutCache(const QString &buildName);
+  bool saveLayoutCache(const QString &buildName);
+
+  // pending layout cache save (done after first full route)
+  const QString &saveLayoutCacheName() const { return saveLayoutCacheName_; }
+  void setSaveLayoutCache(const QString &buildName) { saveLayoutCacheName_ = buildName; }
+
+  void routeView(double view[4]) const;
+
+  bool saveNetlist(const QString &filename);
+  bool loadNetlist(const QString &filename);
+
+  bool exportNetlist(const QString &filename);
+  bool importNetlist(const QString &filename, bool bench=false);
+
+  // check export/import round trip simulates the same (see -netlist_check)
+  bool netlistCheck();
+
+  void moveGate(Gate *gate, const QPointF &d);
 
   void resetObjs();
 
   QSize sizeHint() const override;
 
  private:
+  QString layoutCacheFile(const QString &buildName) const;
+
+  uint64_t calcLayoutHash() const;
+
+  void applyCachedRoutes();
+
+  void compileSim();
+  void compileAig(std::vector<uchar> &aigGates);
+
+  // add fixed stat slots (if empty) and get stat slot of gate's class (cached per gate)
+  void initStats();
+  GateStat &gateStat(const Gate *gate);
+
+ private:
+  // optimized simulation op (single gate or fused pair of inverting gates)
+  struct SimOp {
+    enum class Type {
+      GATE,
+      NAND_NOT,
+      NOT_NOT
+    };
+
+    Type  type  { Type::GATE };
+    Gate* gate1 { nullptr };
+    Gate* gate2 { nullptr };
+
+    SimOp(Type type, Gate *gate1, Gate *gate2=nullptr) :
+     type(type), gate1(gate1), gate2(gate2) {
+    }
+  };
+
+  using SimOps = std::vector<SimOp>;
+
+  using Toggles = std::vector<uint32_t>;
+
  private slots:
   void expandSlot();
   void collapseSlot();
   void placeSlot();
+  void memorySlot();
 
  private:
   Window*         window_                { nullptr };
@@ -640,6 +1313,7 @@ class Schematic : public QFrame {
   bool            placementGroupVisible_ { false };
   bool            gateVisible_           { true };
   bool            collapseBus_           { false };
+  bool            heatmap_               { false };
   Gates           gates_;
   Buses           buses_;
   Connections     connections_;
@@ -647,7 +1321,36 @@ class Schematic : public QFrame {
   int             t_                     { 0 };
   QRectF          rect_;
   QImage          image_;
-  bool            changed_;
+  bool            changed_               { true };
+  QRectF          dirtyRect_;
+  ObjArena        arena_;
+  RouteChannels   routeChannels_;
+  int             numRemoved_            { 0 };
+  Toggles         toggles_;
+  uint32_t        maxToggles_            { 0 };
+  uint64_t        layoutHash_            { 0 };
+  QFile*          routeCacheFile_        { nullptr };
+  const uchar*    routeCacheData_        { nullptr };
+  qint64          routeCacheSize_        { 0 };
+  QString         saveLayoutCacheName_;
+  bool            optimize_              { false };
+  bool            simValid_              { false };
+  SimOps          simOps_;
+  bool            aig_                   { false };
+  SimAig          simAig_;
+  bool            stats_                 { false };
+  GateStats       gateStats_;
+  StatInds        gateStatInds_;         // stat slot per gate (by schemInd)
+  int             statsTicks_            { 0 };
+  StatsPanel*     statsPanel_            { nullptr };
+  MemoryPanel*    memoryPanel_           { nullptr };
+  PaintProfile    paintProfile_;
+  bool            perf_                  { false };
+  PerfCounters    perfCounters_;
+  bool            perfBatch_             { false };
+  long            perfTicks_             { 0 };
+  long            perfEvals_             { 0 };
+  bool            showPaintProfile_      { false };
   Renderer        renderer_;
   QPointF         pressPoint_;
   bool            pressed_               { false };
@@ -671,6 +1374,9 @@ class Waveform : public QFrame {
 
   void addValue(const Connection *connection, int t, bool b);
 
+  // approximate bytes of value history
+  size_t memBytes() const;
+
   QSize sizeHint() const override;
 
  private:
@@ -690,6 +1396,46 @@ class Waveform : public QFrame {
 
 //---
 
+// table of gate class exec stats
+class StatsPanel : public QFrame {
+  Q_OBJECT
+
+ public:
+  StatsPanel(Schematic *schem);
+
+  QSize sizeHint() const override;
+
+ private:
+  void paintEvent(QPaintEvent *) override;
+
+ private:
+  Schematic* schem_ { nullptr };
+};
+
+//---
+
+// memory report (Debug menu) window
+class MemoryPanel : public QFrame {
+  Q_OBJECT
+
+ public:
+  MemoryPanel(Schematic *schem);
+
+  // refresh report lines from schematic
+  void updateLines();
+
+  QSize sizeHint() const override;
+
+ private:
+  void paintEvent(QPaintEvent *) override;
+
+ private:
+  Schematic*           schem_ { nullptr };
+  std::vector<QString> lines_;
+};
+
+//---
+
 class Connection {
  public:
   struct Line {
@@ -754,20 +1500,17 @@ class Connection {
   using Ports = std::vector<Port *>;
   using Lines = std::vector<Line>;
 
+  // horizontal and vertical line segments merged into minimal set of lines
   class LinesData {
-   public:
-    struct ILine {
-      QPoint start;
-      QPoint end;
-
-      ILine(const QPoint &start, const QPoint &end) :
-       start(start), end(end) {
-      }
-    };
-
    public:
     LinesData() { }
 
+    void clear() {
+      xlines_.clear();
+      ylines_.clear();
+      lines_ .clear();
+    }
+
     void addLine(const QPoint &p1, const QPoint &p2) {
       int dx = std::abs(p2.x() - p1.x());
       int dy = std::abs(p2.y() - p1.y());
@@ -781,7 +1524,7 @@ class Connection {
         if (x1 > x2)
           std::swap(x1, x2);
 
-        xlines_[p1.y()][x1].insert(x2);
+        xlines_.push_back(Interval(p1.y(), x1, x2));
       }
       else {
         int y1 = p1.y();
@@ -790,7 +1533,7 @@ class Connection {
         if (y1 > y2)
           std::swap(y1, y2);
 
-        ylines_[p1.x()][y1].insert(y2);
+        ylines_.push_back(Interval(p1.x(), y1, y2));
       }
     }
 
@@ -798,102 +1541,79 @@ class Connection {
       if (lines_.empty()) {
         int ind = 0;
 
-        for (auto &p1 : xlines_) {
-          int y = p1.first;
-
-          IPairs xpairs;
-
-          for (auto &p2 : p1.second) {
-            int x1 = p2.first;
-            int x2 = *p2.second.rbegin();
-
-            xpairs.push_back(IPair(x1, x2));
-          }
-
-          assert(! xpairs.empty());
-
-          auto p = xpairs.begin();
-
-          IPair ipair1 = *p++;
-          IPair ipair2 = ipair1;
-
-          while (p != xpairs.end()) {
-            ipair2 = *p++;
-
-            if ((ipair2.first  >= ipair1.first && ipair2.first  <= ipair1.second) ||
-                (ipair2.second >= ipair1.first && ipair2.second <= ipair1.second)) {
-              ipair1 = IPair(std::min(ipair1.first , ipair2.first ),
-                             std::max(ipair1.second, ipair2.second));
-            }
-            else {
-              lines_.push_back(Line(ind++, QPointF(ipair1.first, y), QPointF(ipair1.second, y)));
+        mergeLines(xlines_, /*horizontal*/true , ind);
+        mergeLines(ylines_, /*horizontal*/false, ind);
+      }
 
-              ipair1 = ipair2;
-            }
-          }
+      return lines_;
+    }
 
-          lines_.push_back(Line(ind++, QPointF(ipair1.first, y), QPointF(ipair1.second, y)));
-        }
+   private:
+    // interval start->end at fixed position (y for horizontal, x for vertical)
+    struct Interval {
+      int pos   { 0 };
+      int start { 0 };
+      int end   { 0 };
+
+      Interval(int pos, int start, int end) :
+       pos(pos), start(start), end(end) {
+      }
 
-        for (auto &p1 : ylines_) {
-          int x = p1.first;
+      bool operator<(const Interval &rhs) const {
+        if (pos != rhs.pos) return (pos < rhs.pos);
 
-          IPairs ypairs;
+        return (start < rhs.start);
+      }
+    };
 
-          for (auto &p2 : p1.second) {
-            int y1 = p2.first;
-            int y2 = *p2.second.rbegin();
+    using Intervals = std::vector<Interval>;
 
-            ypairs.push_back(IPair(y1, y2));
-          }
+    // sort intervals and merge overlapping intervals at same position in single pass
+    void mergeLines(Intervals &intervals, bool horizontal, int &ind) const {
+      if (intervals.empty())
+        return;
 
-          assert(! ypairs.empty());
+      std::sort(intervals.begin(), intervals.end());
 
-          auto p = ypairs.begin();
+      auto addInterval = [&](const Interval &i) {
+        if (horizontal)
+          lines_.push_back(Line(ind++, QPointF(i.start, i.pos), QPointF(i.end, i.pos)));
+        else
+          lines_.push_back(Line(ind++, QPointF(i.pos, i.start), QPointF(i.pos, i.end)));
+      };
 
-          IPair ipair1 = *p++;
-          IPair ipair2 = ipair1;
+      Interval i1 = intervals[0];
 
-          while (p != ypairs.end()) {
-            ipair2 = *p++;
+      auto n = intervals.size();
 
-            if ((ipair2.first  >= ipair1.first && ipair2.first  <= ipair1.second) ||
-                (ipair2.second >= ipair1.first && ipair2.second <= ipair1.second)) {
-              ipair1 = IPair(std::min(ipair1.first , ipair2.first ),
-                             std::max(ipair1.second, ipair2.second));
-            }
-            else {
-              lines_.push_back(Line(ind++, QPointF(x, ipair1.first), QPointF(x, ipair1.second)));
+      for (uint i = 1; i < n; ++i) {
+        const Interval &i2 = intervals[i];
 
-              ipair1 = ipair2;
-            }
-          }
+        if (i2.pos == i1.pos && i2.start <= i1.end)
+          i1.end = std::max(i1.end, i2.end);
+        else {
+          addInterval(i1);
 
-          lines_.push_back(Line(ind++, QPointF(x, ipair1.first), QPointF(x, ipair1.second)));
+          i1 = i2;
         }
       }
 
-      return lines_;
+      addInterval(i1);
     }
 
    private:
-    using ILines   = std::vector<ILine>;
-    using IValues  = std::set<int>;
-    using IPair    = std::pair<int, int>;
-    using IPairs   = std::vector<IPair>;
-    using IValues1 = std::map<int, IValues>;
-    using IValues2 = std::map<int, IValues1>;
-
-    IValues2      xlines_;
-    IValues2      ylines_;
-    mutable Lines lines_;
+    mutable Intervals xlines_;
+    mutable Intervals ylines_;
+    mutable Lines     lines_;
   };
 
  public:
+  CQSCHEM_ARENA_ALLOC
+
   Connection(const QString &name="");
 
-  const QString &name() const { return name_; }
-  void setName(const QString &v) { name_ = v; }
+  const QString &name() const { return NameTable::name(nameInd_); }
+  void setName(const QString &v) { nameInd_ = NameTable::intern(v); }
 
   Schematic *schem() { return schem_; }
   void setSchem(Schematic *p) { schem_ = p; }
@@ -916,6 +1636,10 @@ class Connection {
   Bus *bus() const { return bus_; }
   void setBus(Bus *bus) { bus_ = bus; }
 
+  // index in schematic connections
+  int schemInd() const { return schemInd_; }
+  void setSchemInd(int i) { schemInd_ = i; }
+
   const QRectF &prect() const { return prect_; }
   void setPRect(const QRectF &r) { prect_ = r; }
 
@@ -933,8 +1657,21 @@ class Connection {
 
   void removePort(Port *port);
 
+  void removeDisconnectedPorts();
+
   bool inside(const QPointF &p) const;
 
+  bool isLinesValid() const { return linesValid_; }
+  void invalidateLines() { linesValid_ = false; }
+
+  // pixel bounding box of routed lines
+  const QRectF &linesRect() const { return linesRect_; }
+
+  void updateLines(Renderer *renderer) const;
+
+  const Lines &lines() const { return lines_; }
+  void setLines(Renderer *renderer, const Lines &lines);
+
   void draw(Renderer *renderer) const;
 
   QPointF imidPoint() const;
@@ -943,6 +1680,10 @@ class Connection {
 
   QColor penColor(Renderer *renderer) const;
 
+  // add/remove routed lines to/from shared channel occupancy
+  void releaseChannels(RouteChannels &channels) const;
+  void claimChannels(RouteChannels &channels) const;
+
  private:
   void calcSinglePointLines(Renderer *renderer, const SidePoints &points, Lines &lines) const;
 
@@ -950,6 +1691,10 @@ class Connection {
 
   void calcLines(Renderer *renderer, const SidePoints &points, Lines &lines) const;
 
+  void assignChannels(RouteChannels &channels) const;
+
+  void updateLinesRect() const;
+
   void addConnectLines(const QPointF &p1, const QPointF &p2,
                        const QPointF &p3, const QPointF &p4) const;
 
@@ -963,16 +1708,19 @@ class Connection {
                 bool showText=false) const;
 
  private:
-  QString        name_;
+  int            nameInd_  { 0 };
   Schematic*     schem_    { nullptr };
   bool           value_    { false };
   bool           selected_ { false };
   bool           traced_   { false };
   Ports          inPorts_;
   Ports          outPorts_;
-  Bus*           bus_      { nullptr };
+  Bus*           bus_        { nullptr };
   mutable QRectF prect_;
   mutable Lines  lines_;
+  mutable bool   linesValid_ { false };
+  mutable QRectF linesRect_;
+  int            schemInd_   { -1 };
 };
 
 //---
@@ -1002,6 +1750,10 @@ class Bus {
   bool isSelected() const { return selected_; }
   void setSelected(bool b) { selected_ = b; }
 
+  // index in schematic buses
+  int schemInd() const { return schemInd_; }
+  void setSchemInd(int i) { schemInd_ = i; }
+
   const Position &position() const { return position_; }
   double offset() const { return offset_; }
 
@@ -1009,8 +1761,12 @@ class Bus {
     position_ = position; offset_ = offset;
   }
 
+  Connection *connection(int i) const { return connections_[uint(i)]; }
+
   void addConnection(Connection *connection, int i);
 
+  void replaceConnection(Connection *oldConnection, Connection *newConnection);
+
   int connectionIndex(Connection *connection);
 
   void draw(Renderer *renderer);
@@ -1026,12 +1782,15 @@ class Bus {
   bool        selected_     { false };
   Position    position_     { Position::MIDDLE };
   double      offset_       { 0.0 };
+  int         schemInd_     { -1 };
 };
 
 //---
 
 class Port {
  public:
+  CQSCHEM_ARENA_ALLOC
+
   Port(const QString &name, const Direction &direction) :
    name_(name), direction_(direction) {
   }
@@ -1102,15 +1861,24 @@ class Gate {
     R270
   };
 
-  using Ports = std::vector<Port *>;
+  using Ports       = std::vector<Port *>;
+  using Connections = std::vector<Connection *>;
+
+  // interned port names and name to port index map shared by gates of same type
+  struct PortTable;
 
  public:
+  CQSCHEM_ARENA_ALLOC
+
   Gate(const QString &name);
 
   virtual ~Gate();
 
-  const QString &name() const { return name_; }
-  void setName(const QString &v) { name_ = v; }
+  // name is local name qualified by index names of containing placement groups
+  QString name() const;
+  void setName(const QString &v) { nameInd_ = NameTable::intern(v); }
+
+  const QString &localName() const { return NameTable::name(nameInd_); }
 
   Schematic *schem() { return schem_; }
   void setSchem(Schematic *p) { schem_ = p; }
@@ -1125,16 +1893,32 @@ class Gate {
   void setSelected(bool b) { selected_ = b; }
 
   void connect(const QString &name, Connection *connection);
+  void connect(int portIndex, Connection *connection);
+
+  // connect i'th input/output port (index order of inputs/outputs)
+  void connectInput (int i, Connection *connection) { connect(i, connection); }
+  void connectOutput(int i, Connection *connection) {
+    connect(int(inputs_.size()) + i, connection); }
 
   const Ports &inputs () const { return inputs_ ; }
   const Ports &outputs() const { return outputs_; }
 
+  void connections(Connections &connections) const;
+
   const QRectF &rect() const { return rect_; }
   void setRect(const QRectF &v) { rect_ = v; }
 
+  const QRectF &prect() const { return prect_; }
+
+  void translatePixelRect(double dx, double dy) const;
+
   PlacementGroup *placementGroup() const { return placementGroup_; }
   void setPlacementGroup(PlacementGroup *g) { placementGroup_ = g; }
 
+  // index in schematic gates
+  int schemInd() const { return schemInd_; }
+  void setSchemInd(int i) { schemInd_ = i; }
+
   void addInputPorts(const QStringList &names) {
     for (const auto &name : names)
       addInputPort(name);
@@ -1148,8 +1932,18 @@ class Gate {
   void addInputPort (const QString &name);
   void addOutputPort(const QString &name);
 
+  const QString &internPortName(const QString &name) const;
+
   Port *getPortByName(const QString &name) const;
 
+  // port index (inputs then outputs) of named port (-1 if not found)
+  int portIndex(const QString &name) const;
+
+  Port *portByIndex(int i) const {
+    auto ni = int(inputs_.size());
+    return (i < ni ? inputs_[uint(i)] : outputs_[uint(i - ni)]);
+  }
+
   double px1() const { return prect_.left  (); }
   double py1() const { return prect_.top   (); }
   double px2() const { return prect_.right (); }
@@ -1252,6 +2046,9 @@ class Gate {
 
   virtual bool exec() = 0;
 
+  // approximate heap bytes owned by gate (excluding ports)
+  virtual size_t heapBytes() const;
+
   virtual void draw(Renderer *renderer) const;
 
   void setBrush(Renderer *renderer) const;
@@ -1321,7 +2118,7 @@ class Gate {
   }
 
  protected:
-  QString         name_;
+  int             nameInd_        { 0 };
   Schematic*      schem_          { nullptr };
   Orientation     orientation_    { Orientation::R0 };
   bool            flipped_        { false };
@@ -1334,6 +2131,9 @@ class Gate {
   double          h_              { 0.8 };
   double          margin_         { 0.1 };
   PlacementGroup* placementGroup_ { nullptr };
+  int             schemInd_       { -1 };
+
+  mutable const PortTable *portTable_ { nullptr };
 };
 
 //---
@@ -1480,6 +2280,52 @@ class Memory8Gate : public Gate {
 
 //---
 
+// array of nr x nc RAM cells (row/column select and gates, enables and register) sharing
+// one gate. Per cell net values and register bits are stored in compact arrays and
+// executed in the same order as the separate cell gates.
+//
+// inputs : h0..h<nr-1> (row), v0..v<nc-1> (column), i0..i7, s, e
+// outputs: o0..o7
+class RamArrayGate : public Gate {
+ public:
+  RamArrayGate(const QString &name, int nr=16, int nc=16);
+
+  int numRows   () const { return nr_; }
+  int numColumns() const { return nc_; }
+
+  // register bits of cell (row major index)
+  uchar cellState(int i) const { return state_[uint(i)]; }
+  void setCellState(int i, uchar state);
+
+  bool exec() override;
+
+  size_t heapBytes() const override;
+
+  void draw(Renderer *renderer) const override;
+
+  static QString hname(int i) { return QString("h%1").arg(i); }
+  static QString vname(int i) { return QString("v%1").arg(i); }
+  static QString iname(int i) { return QString("i%1").arg(i); }
+  static QString oname(int i) { return QString("o%1").arg(i); }
+
+ private:
+  enum NetBits {
+    T1_BIT = 1, // row and column selected
+    T2_BIT = 2, // cell set
+    T3_BIT = 4  // cell enabled
+  };
+
+  using Bytes = std::vector<uchar>;
+
+  int   nr_ { 16 };
+  int   nc_ { 16 };
+  Bytes nets_;   // net bits per cell
+  Bytes state_;  // register bits per cell
+  Bytes output_; // register output bits per cell
+};
+
+//---
+
 class EnablerGate : public Gate {
  public:
   EnablerGate(const QString &name);
@@ -1504,6 +2350,9 @@ class RegisterGate : public Gate {
  public:
   RegisterGate(const QString &name);
 
+  uchar stateBits() const;
+  void setStateBits(uchar bits);
+
   bool exec() override;
 
   void draw(Renderer *renderer) const override;
@@ -1843,7 +2692,10 @@ class ClkGate : public Gate {
  public:
   ClkGate(const QString &name="");
 
+  int delay() const { return delay_; }
   void setDelay(int delay) { delay_ = delay; delay1_ = delay_; }
+
+  int cycle() const { return cycle_; }
   void setCycle(int cycle) { cycle_ = cycle; cycle1_ = cycle_; }
 
   bool exec() override;
@@ -0,0 +1,75 @@
+#ifndef HEATMAP_pixmap_H
+#define HEATMAP_pixmap_H
+
+#include <CQPixmapCache.h>
+
+class HEATMAP_pixmap {
+ private:
+  uchar data_[882] = {
+    0x3c,0x3f,0x78,0x6d,0x6c,0x20,0x76,0x65,0x72,0x73,0x69,0x6f,0x6e,0x3d,0x22,0x31,
+    0x2e,0x30,0x22,0x20,0x65,0x6e,0x63,0x6f,0x64,0x69,0x6e,0x67,0x3d,0x22,0x55,0x54,
+    0x46,0x2d,0x38,0x22,0x20,0x73,0x74,0x61,0x6e,0x64,0x61,0x6c,0x6f,0x6e,0x65,0x3d,
+    0x22,0x6e,0x6f,0x22,0x3f,0x3e,0x0a,0x3c,0x73,0x76,0x67,0x0a,0x20,0x20,0x20,0x78,
+    0x6d,0x6c,0x6e,0x73,0x3a,0x73,0x76,0x67,0x3d,0x22,0x68,0x74,0x74,0x70,0x3a,0x2f,
+    0x2f,0x77,0x77,0x77,0x2e,0x77,0x33,0x2e,0x6f,0x72,0x67,0x2f,0x32,0x30,0x30,0x30,
+    0x2f,0x73,0x76,0x67,0x22,0x0a,0x20,0x20,0x20,0x78,0x6d,0x6c,0x6e,0x73,0x3d,0x22,
+    0x68,0x74,0x74,0x70,0x3a,0x2f,0x2f,0x77,0x77,0x77,0x2e,0x77,0x33,0x2e,0x6f,0x72,
+    0x67,0x2f,0x32,0x30,0x30,0x30,0x2f,0x73,0x76,0x67,0x22,0x0a,0x20,0x20,0x20,0x77,
+    0x69,0x64,0x74,0x68,0x3d,0x22,0x34,0x34,0x38,0x22,0x0a,0x20,0x20,0x20,0x68,0x65,
+    0x69,0x67,0x68,0x74,0x3d,0x22,0x34,0x34,0x38,0x22,0x0a,0x20,0x20,0x20,0x69,0x64,
+    0x3d,0x22,0x73,0x76,0x67,0x32,0x22,0x0a,0x20,0x20,0x20,0x76,0x65,0x72,0x73,0x69,
+    0x6f,0x6e,0x3d,0x22,0x31,0x2e,0x31,0x22,0x3e,0x0a,0x20,0x20,0x3c,0x67,0x0a,0x20,
+    0x20,0x20,0x20,0x20,0x69,0x64,0x3d,0x22,0x6c,0x61,0x79,0x65,0x72,0x31,0x22,0x3e,
+    0x0a,0x20,0x20,0x20,0x20,0x3c,0x70,0x61,0x74,0x68,0x0a,0x20,0x20,0x20,0x20,0x20,
+    0x20,0x20,0x73,0x74,0x79,0x6c,0x65,0x3d,0x22,0x66,0x69,0x6c,0x6c,0x3a,0x6e,0x6f,
+    0x6e,0x65,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x3a,0x23,0x34,0x31,0x36,0x39,0x65,
+    0x31,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x77,0x69,0x64,0x74,0x68,0x3a,0x34,
+    0x30,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x6c,0x69,0x6e,0x65,0x63,0x61,0x70,
+    0x3a,0x62,0x75,0x74,0x74,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x6c,0x69,0x6e,
+    0x65,0x6a,0x6f,0x69,0x6e,0x3a,0x6d,0x69,0x74,0x65,0x72,0x22,0x0a,0x20,0x20,0x20,
+    0x20,0x20,0x20,0x20,0x64,0x3d,0x22,0x4d,0x20,0x32,0x30,0x2c,0x36,0x30,0x20,0x48,
+    0x20,0x32,0x30,0x30,0x20,0x56,0x20,0x31,0x36,0x30,0x20,0x48,0x20,0x34,0x32,0x38,
+    0x22,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x69,0x64,0x3d,0x22,0x70,0x61,0x74,
+    0x68,0x31,0x22,0x20,0x2f,0x3e,0x0a,0x20,0x20,0x20,0x20,0x3c,0x70,0x61,0x74,0x68,
+    0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x73,0x74,0x79,0x6c,0x65,0x3d,0x22,0x66,
+    0x69,0x6c,0x6c,0x3a,0x6e,0x6f,0x6e,0x65,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x3a,
+    0x23,0x33,0x32,0x63,0x64,0x33,0x32,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x77,
+    0x69,0x64,0x74,0x68,0x3a,0x34,0x30,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x6c,
+    0x69,0x6e,0x65,0x63,0x61,0x70,0x3a,0x62,0x75,0x74,0x74,0x3b,0x73,0x74,0x72,0x6f,
+    0x6b,0x65,0x2d,0x6c,0x69,0x6e,0x65,0x6a,0x6f,0x69,0x6e,0x3a,0x6d,0x69,0x74,0x65,
+    0x72,0x22,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x64,0x3d,0x22,0x4d,0x20,0x32,
+    0x30,0x2c,0x32,0x32,0x34,0x20,0x48,0x20,0x34,0x32,0x38,0x22,0x0a,0x20,0x20,0x20,
+    0x20,0x20,0x20,0x20,0x69,0x64,0x3d,0x22,0x70,0x61,0x74,0x68,0x32,0x22,0x20,0x2f,
+    0x3e,0x0a,0x20,0x20,0x20,0x20,0x3c,0x70,0x61,0x74,0x68,0x0a,0x20,0x20,0x20,0x20,
+    0x20,0x20,0x20,0x73,0x74,0x79,0x6c,0x65,0x3d,0x22,0x66,0x69,0x6c,0x6c,0x3a,0x6e,
+    0x6f,0x6e,0x65,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x3a,0x23,0x66,0x66,0x61,0x35,
+    0x30,0x30,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x77,0x69,0x64,0x74,0x68,0x3a,
+    0x34,0x30,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x6c,0x69,0x6e,0x65,0x63,0x61,
+    0x70,0x3a,0x62,0x75,0x74,0x74,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,0x2d,0x6c,0x69,
+    0x6e,0x65,0x6a,0x6f,0x69,0x6e,0x3a,0x6d,0x69,0x74,0x65,0x72,0x22,0x0a,0x20,0x20,
+    0x20,0x20,0x20,0x20,0x20,0x64,0x3d,0x22,0x4d,0x20,0x32,0x30,0x2c,0x33,0x38,0x38,
+    0x20,0x48,0x20,0x31,0x36,0x30,0x20,0x56,0x20,0x32,0x38,0x38,0x20,0x48,0x20,0x34,
+    0x32,0x38,0x22,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x69,0x64,0x3d,0x22,0x70,
+    0x61,0x74,0x68,0x33,0x22,0x20,0x2f,0x3e,0x0a,0x20,0x20,0x20,0x20,0x3c,0x70,0x61,
+    0x74,0x68,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x73,0x74,0x79,0x6c,0x65,0x3d,
+    0x22,0x66,0x69,0x6c,0x6c,0x3a,0x6e,0x6f,0x6e,0x65,0x3b,0x73,0x74,0x72,0x6f,0x6b,
+    0x65,0x3a,0x23,0x64,0x63,0x31,0x34,0x33,0x63,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,
+    0x2d,0x77,0x69,0x64,0x74,0x68,0x3a,0x34,0x30,0x3b,0x73,0x74,0x72,0x6f,0x6b,0x65,
+    0x2d,0x6c,0x69,0x6e,0x65,0x63,0x61,0x70,0x3a,0x62,0x75,0x74,0x74,0x3b,0x73,0x74,
+    0x72,0x6f,0x6b,0x65,0x2d,0x6c,0x69,0x6e,0x65,0x6a,0x6f,0x69,0x6e,0x3a,0x6d,0x69,
+    0x74,0x65,0x72,0x22,0x0a,0x20,0x20,0x20,0x20,0x20,0x20,0x20,0x64,0x3d,0x22,0x4d,
+    0x20,0x33,0x32,0x38,0x2c,0x32,0x30,0x20,0x56,0x20,0x34,0x32,0x38,0x22,0x0a,0x20,
+    0x20,0x20,0x20,0x20,0x20,0x20,0x69,0x64,0x3d,0x22,0x70,0x61,0x74,0x68,0x34,0x22,
+    0x20,0x2f,0x3e,0x0a,0x20,0x20,0x3c,0x2f,0x67,0x3e,0x0a,0x3c,0x2f,0x73,0x76,0x67,
+    0x3e,0x0a,
+};
+
+ public:
+  HEATMAP_pixmap() {
+    CQPixmapCache::instance()->addData("HEATMAP", data_, 882);
+  }
+};
+
+static HEATMAP_pixmap s_HEATMAP_pixmap;
+
+#endif